@@ -0,0 +1,161 @@
+/*
+ * @brief This file keeps the asset directory (superblock) in the m24m02 identification page. 
+ *        it maps an asset uid to its offset, length, codec and crc in the array, 
+ *        and is cached in RAM at boot, so finding an asset costs no i2c access 
+ *        and reading it a single sequential read. 
+ */
+#include "asset_dir.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(asset_dir, LOG_LEVEL_ERR);
+
+/*
+ * @brief empty directory in RAM
+ */
+static void asset_dir_reset(void) {
+    memset(&asset_dir, 0, sizeof(asset_dir));
+    memcpy(asset_dir.header.magic, "dir", sizeof(asset_dir.header.magic));
+    asset_dir.header.version = ASSET_DIR_VERSION;
+    asset_dir.header.count = 0;
+}
+
+/*
+ * @brief asset directory init func, read the identification page into RAM
+ *        an unformatted or corrupted page gives an empty directory. 
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int asset_dir_init(void) {
+    if (m24m02e_read(0x00, (uint8_t *)&asset_dir, sizeof(asset_dir))) {
+        asset_dir_reset();
+        return -1;
+    }
+
+    if (memcmp(asset_dir.header.magic, "dir", sizeof(asset_dir.header.magic)) 
+            || asset_dir.header.version != ASSET_DIR_VERSION 
+            || asset_dir.header.count > ASSET_DIR_ENTRY_MAX 
+            || asset_dir.header.crc != crc32_calc((uint8_t *)asset_dir.entries, 
+                    asset_dir.header.count * sizeof(struct asset_dir_entry_st))) {
+        LOG_ERR("no valid asset directory, start empty!");
+        asset_dir_reset();
+        return 0;
+    }
+
+    LOG_DBG("asset directory has %d entries...", asset_dir.header.count);
+
+    return 0;
+}
+
+/*
+ * @brief find an asset
+ *
+ * @param uid asset uid
+ * @param entry where the directory entry will be copied to
+ *
+ * @retval 0 succeed
+ * @retval -1 not found
+ */
+int asset_dir_find(uint16_t uid, struct asset_dir_entry_st *entry) {
+    for (uint8_t i = 0; i < asset_dir.header.count; i++) {
+        if (asset_dir.entries[i].uid == uid) {
+            *entry = asset_dir.entries[i];
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * @brief add or replace an asset in the RAM directory, asset_dir_commit() writes it back
+ *
+ * @param entry directory entry
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, directory full or asset out of range
+ */
+int asset_dir_put(const struct asset_dir_entry_st *entry) {
+    uint8_t i;
+
+    if (entry->offset > M24M02_SIZE || entry->length > M24M02_SIZE - entry->offset) {
+        return -1;
+    }
+
+    for (i = 0; i < asset_dir.header.count; i++) {
+        if (asset_dir.entries[i].uid == entry->uid) {
+            break;
+        }
+    }
+
+    if (i == ASSET_DIR_ENTRY_MAX) {
+        LOG_ERR("asset directory full!");
+        return -1;
+    }
+
+    asset_dir.entries[i] = *entry;
+    if (i == asset_dir.header.count) {
+        asset_dir.header.count++;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief write the RAM directory into the identification page, one page write
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int asset_dir_commit(void) {
+    asset_dir.header.crc = crc32_calc((uint8_t *)asset_dir.entries, 
+            asset_dir.header.count * sizeof(struct asset_dir_entry_st));
+
+    return m24m02e_write(0x00, (uint8_t *)&asset_dir, sizeof(asset_dir));
+}
+
+/*
+ * @brief open a prefetch stream over an asset
+ *
+ * @param uid asset uid
+ * @param pf prefetch stream
+ * @param entry where the directory entry will be copied to, for asset_verify()
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, not found
+ */
+int asset_open(uint16_t uid, struct m24m02_prefetch_st *pf, struct asset_dir_entry_st *entry) {
+    if (asset_dir_find(uid, entry)) {
+        LOG_ERR("asset 0x%.04x not found!", uid);
+        return -1;
+    }
+
+    return m24m02_prefetch_open(pf, entry->offset, entry->length);
+}
+
+/*
+ * @brief check a fully streamed asset against its directory crc
+ *        the crc was computed while streaming, no extra i2c traffic. 
+ *
+ * @param stream stream read to its end
+ * @param entry directory entry of the asset
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, stream not finished or crc mismatch
+ */
+int asset_verify(const struct m24m02_stream_st *stream, const struct asset_dir_entry_st *entry) {
+    if (stream->addr != stream->end) {
+        return -1;
+    }
+
+    if (stream->crc != entry->crc) {
+        LOG_ERR("asset 0x%.04x crc 0x%.08x, expected 0x%.08x!", entry->uid, stream->crc, entry->crc);
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef _ASSET_DIR_H_
+#define _ASSET_DIR_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define ASSET_DIR_VERSION 0x01
+#define ASSET_DIR_PAGE_SIZE 256
+#define ASSET_DIR_ENTRY_MAX 15                                                                      // (256 - 16) / 16
+
+/*
+ * @brief identification page layout, little endian
+ *        +--------+---------+-------+----------+-----+
+ *        | "dir"  | version | count | reserved | crc |   header, 16 byte
+ *        +--------+---------+-------+----------+-----+
+ *        | entry 0 ... entry 14                       |   16 byte each
+ *        +--------------------------------------------+
+ *        crc is the crc32 of entry 0 ... entry (count - 1). 
+ */
+struct asset_dir_header_st {
+    uint8_t magic[3];                                                                               // ASCII "dir"
+    uint8_t version;
+    uint8_t count;
+    uint8_t reserved[7];
+    uint32_t crc;
+} __packed;
+
+struct asset_dir_page_st {
+    struct asset_dir_header_st header;
+    struct asset_dir_entry_st entries[ASSET_DIR_ENTRY_MAX];
+} __packed;
+
+BUILD_ASSERT(sizeof(struct asset_dir_page_st) == ASSET_DIR_PAGE_SIZE);
+
+static struct asset_dir_page_st asset_dir;                                                          // RAM copy of the page
+
+static void asset_dir_reset(void);
+
+#endif
\ No newline at end of file
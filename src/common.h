@@ -2,6 +2,7 @@
 #define _COMMON_H_
 
 #include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
 
 int ds3231_init(void);
 int ds3231_time_write(uint8_t seconds, uint8_t minutes, uint8_t hours, 
@@ -16,7 +17,46 @@ uint8_t ds3231_get_time_hours_tens(void);
 void ds3231_bcd_time_curr_print(void);
 void ds3231_dec_time_curr_print(void);
 
+int i2c_bus_acquire(const struct device *dev, uint32_t speed);
+void i2c_bus_release(const struct device *dev);
+uint32_t i2c_bus_speed_get(const struct device *dev);
+
+struct st7735_rect_st {
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+};
+
+#define ST7735_COLOR_WHITE 0xFFFF                                                                   // RGB565, the panel is BGR
+#define ST7735_COLOR_RED 0x001F
+#define ST7735_COLOR_GREEN 0x07E0
+#define ST7735_COLOR_BLUE 0xF800
+#define ST7735_COLOR_BLACK 0x0000
+
+typedef int (*st7735_render_cb_t)(const struct st7735_rect_st *rect, void *user_data);
+typedef int (*st7735_line_cb_t)(uint8_t row, uint8_t *line, uint8_t w, void *user_data);
+typedef int (*st7735_read_cb_t)(uint8_t *buf, size_t length, void *user_data);
+
+struct m24m02_stream_st;
+
+struct st7735_push_stats_st {
+    uint32_t bytes;                                                                                 // last frame
+    uint32_t frame_us;
+    uint32_t cpu_us;                                                                                // in the line callback
+    uint32_t spi_us;                                                                                // transfers on the wire
+    uint32_t wait_us;                                                                               // cpu waiting for spi
+};
+
 int st7735_init(void);
+int st7735_blit(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint8_t *pixels);
+int st7735_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color);
+int st7735_push(uint8_t x, uint8_t y, uint8_t w, uint8_t h, st7735_line_cb_t fill, void *user_data);
+int st7735_stream(uint8_t x, uint8_t y, uint8_t w, uint8_t h, st7735_read_cb_t read, void *user_data);
+int st7735_blit_m24m02(uint8_t x, uint8_t y, uint8_t w, uint8_t h, struct m24m02_stream_st *stream);
+void st7735_push_stats_get(struct st7735_push_stats_st *stats);
+void st7735_dirty_add(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+int st7735_dirty_flush(st7735_render_cb_t render, void *user_data);
 // int st7735_screen_write(void);
 
 int nrf52832_init(void);
@@ -24,11 +64,176 @@ int nrf52832_init(void);
 void write_screen_thread_suspend(void);
 void write_screen_thread_resume(void);
 
+struct m24m02_twr_stats_st {
+    uint32_t count;                                                                                 // write cycles observed
+    uint32_t timeouts;
+    uint32_t last_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+};
+
+#define M24M02_SIZE_ADD(node) DT_PROP(node, size) + 
+#define M24M02_SIZE (DT_FOREACH_STATUS_OKAY(cubewatch_m24xx, M24M02_SIZE_ADD) 0)                    // all chips, 256K with one m24m02
+
+/*
+ * @brief m24m02 memory map, with one m24m02
+ *        0x00000 - 0x3CFFF assets (fonts at 0x00000, see CW_FONT_EEPROM_ADDR)
+ *        0x3D000 - 0x3EFFF key/value store, 2 banks of 4K
+ *        0x3F000 - 0x3FFFF page wear counters, 1024 x uint32
+ *        key/value store and wear counters stay at the end when chips are added. 
+ */
+#define M24M02_WEAR_SIZE (M24M02_SIZE / 256 * sizeof(uint32_t))                                     // 1 counter per 256 byte
+#define M24M02_WEAR_ADDR (M24M02_SIZE - M24M02_WEAR_SIZE)
+#define M24M02_KVS_SIZE 0x2000
+#define M24M02_KVS_ADDR (M24M02_WEAR_ADDR - M24M02_KVS_SIZE)
+
 int m24m02_init(void);
+int m24m02_write(uint32_t addr, uint8_t *buf, size_t length);
+int m24m02_read(uint32_t addr, uint8_t *buf, size_t length);
+int m24m02_write_diff(uint32_t addr, uint8_t *buf, size_t length);
+int m24m02_bus_write(uint32_t addr, uint8_t *buf, size_t length);                                   // bypass page cache
+int m24m02_bus_read(uint32_t addr, uint8_t *buf, size_t length);                                    // bypass page cache
 int m24m02x_write(uint8_t sector, uint8_t addr_high, uint8_t addr_low, uint8_t *buf, size_t length);
 int m24m02e_write(uint8_t addr, uint8_t *buf, size_t length);
 int m24m02x_read(uint8_t sector, uint8_t addr_high, uint8_t addr_low, uint8_t *buf, size_t length);
 int m24m02e_read(uint8_t addr, uint8_t *buf, size_t length);
+uint32_t m24m02_bus_speed_set(uint32_t speed);
+uint32_t m24m02_bus_speed_get(void);
+
+struct m24m02_bench_st {
+    uint32_t speed;                                                                                 // I2C_SPEED_xx requested
+    uint32_t applied_speed;                                                                         // I2C_SPEED_xx the bus ran at
+    uint32_t read_bytes_per_s;                                                                      // sequential read
+    uint32_t write_bytes_per_s;                                                                     // page write, ACK polled
+};
+
+int m24m02_bench(struct m24m02_bench_st *results);
+void m24m02_twr_stats_get(struct m24m02_twr_stats_st *stats);
+
+struct m24m02_diff_stats_st {
+    uint32_t pages_skipped;                                                                         // already matched
+    uint32_t pages_programmed;
+    uint32_t bytes_programmed;
+};
+
+void m24m02_diff_stats_get(struct m24m02_diff_stats_st *stats);
+
+struct m24m02_fill_stats_st {
+    uint32_t bytes;                                                                                 // last fill
+    uint32_t pages;                                                                                 // write cycles
+    uint32_t elapsed_us;
+    uint32_t bytes_per_s;
+};
+
+int m24m02_fill(uint32_t addr, size_t length, uint8_t pattern);
+void m24m02_fill_stats_get(struct m24m02_fill_stats_st *stats);
+
+struct m24m02_cache_stats_st {
+    uint32_t hits;                                                                                  // pages served from RAM
+    uint32_t misses;                                                                                // pages loaded from bus
+    uint32_t bypasses;                                                                              // reads larger than the cache
+    uint32_t evictions;
+    uint32_t write_backs;                                                                           // dirty pages programmed
+};
+
+int m24m02_cache_read(uint32_t addr, uint8_t *buf, size_t length);
+int m24m02_cache_peek(uint32_t addr, uint8_t *buf, size_t length);                                  // no line allocated
+int m24m02_cache_write(uint32_t addr, uint8_t *buf, size_t length);
+int m24m02_cache_flush(void);
+void m24m02_cache_invalidate(void);
+void m24m02_cache_stats_get(struct m24m02_cache_stats_st *stats);
+
+struct m24m02_stream_st {
+    uint32_t addr;                                                                                  // next address
+    uint32_t end;
+    uint32_t crc;                                                                                   // crc32 of byte read so far
+};
+
+int m24m02_stream_open(struct m24m02_stream_st *stream, uint32_t addr, size_t length);
+int m24m02_stream_read(struct m24m02_stream_st *stream, uint8_t *buf, size_t length);
+
+struct m24m02_prefetch_st {
+    struct m24m02_stream_st stream;
+    uint8_t buf[2][CONFIG_M24M02_PREFETCH_SIZE];                                                    // double buffer
+    int length[2];                                                                                  // byte fetched, -1 failed
+    struct k_sem ready[2];
+    uint8_t curr;                                                                                   // buffer owned by consumer
+    uint8_t pending;                                                                                // bit n: buf[n] being fetched
+    uint32_t stall_us;                                                                              // wait not hidden by prefetch
+    uint32_t stalls;
+};
+
+int m24m02_prefetch_open(struct m24m02_prefetch_st *pf, uint32_t addr, size_t length);
+int m24m02_prefetch_get(struct m24m02_prefetch_st *pf, uint8_t **data);
+void m24m02_prefetch_release(struct m24m02_prefetch_st *pf);
+void m24m02_prefetch_close(struct m24m02_prefetch_st *pf);
+
+struct m24m02_coalesce_stats_st {
+    uint32_t writes;                                                                                // coalesced writes in
+    uint32_t page_writes;                                                                           // page writes out
+    uint32_t errors;
+};
+
+int m24m02_wear_init(void);
+void m24m02_wear_count(uint32_t addr);
+int m24m02_wear_flush(void);
+int m24m02_wear_get(uint16_t page, uint32_t *count);
+int m24m02_wear_hottest(uint16_t *page, uint32_t *count);
+
+int m24m02_coalesce_init(void);
+int m24m02_coalesce_write(uint32_t addr, const uint8_t *buf, size_t length);
+int m24m02_coalesce_flush(void);
+void m24m02_coalesce_stats_get(struct m24m02_coalesce_stats_st *stats);
+
+struct rtio;
+struct rtio_sqe;
+
+struct rtio_sqe *m24m02_rtio_prep_read(struct rtio *r, uint32_t addr, uint8_t *buf, size_t length, 
+        void *userdata);
+struct rtio_sqe *m24m02_rtio_prep_write(struct rtio *r, uint32_t addr, const uint8_t *buf, 
+        size_t length, void *userdata);
+
+typedef void (*m24m02_write_cb_t)(int result, uint32_t addr, uint8_t *buf, size_t length, 
+        void *user_data);
+
+int m24m02_write_async(uint32_t addr, uint8_t *buf, size_t length, 
+        m24m02_write_cb_t cb, void *user_data);
+int m24m02_write_async_signal(uint32_t addr, uint8_t *buf, size_t length, 
+        struct k_poll_signal *signal);
+
+#define ASSET_CODEC_RAW 0x00
+#define ASSET_CODEC_QOI 0x01
+
+struct asset_dir_entry_st {
+    uint16_t uid;
+    uint8_t codec;                                                                                  // ASSET_CODEC_xx
+    uint8_t flags;
+    uint32_t offset;                                                                                // A17-A0
+    uint32_t length;
+    uint32_t crc;                                                                                   // crc32 of asset data
+} __packed;
+
+int asset_dir_init(void);
+int asset_dir_find(uint16_t uid, struct asset_dir_entry_st *entry);
+int asset_dir_put(const struct asset_dir_entry_st *entry);
+int asset_dir_commit(void);
+int asset_open(uint16_t uid, struct m24m02_prefetch_st *pf, struct asset_dir_entry_st *entry);
+int asset_verify(const struct m24m02_stream_st *stream, const struct asset_dir_entry_st *entry);
+
+#define KVS_VALUE_SIZE_MAX 32
+
+#define KVS_KEY_WATCH_FACE 0x0001
+#define KVS_KEY_BRIGHTNESS 0x0002
+#define KVS_KEY_LAST_SYNC_TIME 0x0003
+
+int kvs_init(void);
+int kvs_write(uint16_t key, const void *value, uint8_t length);
+int kvs_read(uint16_t key, void *value, uint8_t length);
+int kvs_delete(uint16_t key);
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length);
+uint32_t crc32_calc(const uint8_t *data, size_t length);
 
 void qoi_init(void);
 
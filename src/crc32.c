@@ -0,0 +1,48 @@
+/*
+ * @brief This file is a table driven (slice-by-4) crc32, IEEE 802.3, 
+ *        same result as crc32_ieee() but 4 byte per step instead of 1 bit, 
+ *        so asset data can be checked on the fly while it is streamed out of m24m02. 
+ */
+#include "crc32.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+/*
+ * @brief continue a crc32 over more data
+ *
+ * @param crc crc32 of the data before, 0 to start
+ * @param data data
+ * @param length data length
+ *
+ * @retval crc32 of all data so far
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length) {
+    crc = ~crc;
+
+    while (length >= 4) {
+        crc ^= data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+        crc = crc32_table[3][crc & 0xFF] ^ crc32_table[2][(crc >> 8) & 0xFF] 
+                ^ crc32_table[1][(crc >> 16) & 0xFF] ^ crc32_table[0][crc >> 24];
+        data += 4;
+        length -= 4;
+    }
+
+    while (length--) {
+        crc = crc32_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+/*
+ * @brief crc32 of a buffer
+ *
+ * @param data data
+ * @param length data length
+ *
+ * @retval crc32
+ */
+uint32_t crc32_calc(const uint8_t *data, size_t length) {
+    return crc32_update(0, data, length);
+}
\ No newline at end of file
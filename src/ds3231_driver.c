@@ -55,7 +55,17 @@ static int ds3231_control_reg_init(void) {
  * @retval -1 failed
  */
 static int ds3231_write(size_t length) {
-    return i2c_write_dt(&ds3231_i2c, ds3231_tx_buf, length);
+    int ret;
+
+    if (i2c_bus_acquire(ds3231_i2c.bus, DS3231_BUS_SPEED)) {
+        return -1;
+    }
+
+    ret = i2c_write_dt(&ds3231_i2c, ds3231_tx_buf, length);
+
+    i2c_bus_release(ds3231_i2c.bus);
+
+    return ret;
 }
 
 /*
@@ -87,7 +97,17 @@ int ds3231_time_write(uint8_t seconds, uint8_t minutes, uint8_t hours,
  * @retval -1 failed
  */
 int ds3231_time_read(void) {
-    if (i2c_write_read_dt(&ds3231_i2c, ds3231_rx_addr, 1, &ds3231_bcd_time_curr, 7)) {
+    int ret;
+
+    if (i2c_bus_acquire(ds3231_i2c.bus, DS3231_BUS_SPEED)) {
+        return -1;
+    }
+
+    ret = i2c_write_read_dt(&ds3231_i2c, ds3231_rx_addr, 1, &ds3231_bcd_time_curr, 7);
+
+    i2c_bus_release(ds3231_i2c.bus);
+
+    if (ret) {
         return -1;
     }
     ds3231_time_bcd_2_dec();
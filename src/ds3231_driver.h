@@ -2,6 +2,7 @@
 #define _DS3231_DRIVER_H_
 
 #include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
 
 #define DS3231_SECONDS_REG_ADDRESS          0x00
 #define DS3231_MINUTES_REG_ADDRESS          0x01
@@ -12,6 +13,8 @@
 #define DS3231_YEAR_REG_ADDRESS             0x06
 #define DS3231_CONTROL_REG_ADDRESS			0x0E
 
+#define DS3231_BUS_SPEED I2C_SPEED_STANDARD                                                         // 100 kHz, shared with m24m02
+
 #define DS3231_TX_BUF_SIZE_MAX 20                                                                   // 19 register + addr
 #define DS3231_RX_ADDR_BUF_SIZE 1
 
@@ -0,0 +1,57 @@
+/*
+ * @brief This file is an i2c emulator of ds3231 for native_sim, a plain register file 
+ *        with the register pointer, so ds3231_init() and the time read / write succeed. 
+ *        the clock does not run. 
+ */
+#include "ds3231_emul.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/drivers/emul.h>
+
+/*
+ * @brief i2c emulator transfer, first written byte sets the register pointer, 
+ *        following bytes are written or read at the pointer, which then increments. 
+ *
+ * @retval 0 succeed
+ */
+static int ds3231_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs, 
+        int addr) {
+    struct ds3231_emul_data_st *data = target->data;
+
+    for (int i = 0; i < num_msgs; i++) {
+        for (uint32_t j = 0; j < msgs[i].len; j++) {
+            if (msgs[i].flags & I2C_MSG_READ) {
+                msgs[i].buf[j] = data->regs[data->pointer];
+            } else if (j == 0) {
+                data->pointer = msgs[i].buf[j] % DS3231_EMUL_REG_COUNT;
+                continue;
+            } else {
+                data->regs[data->pointer] = msgs[i].buf[j];
+            }
+            data->pointer = (data->pointer + 1) % DS3231_EMUL_REG_COUNT;
+        }
+    }
+
+    return 0;
+}
+
+static const struct i2c_emul_api ds3231_emul_api = {
+    .transfer = ds3231_emul_transfer, 
+};
+
+static int ds3231_emul_init(const struct emul *target, const struct device *parent) {
+    return 0;
+}
+
+static int ds3231_emul_dev_init(const struct device *dev) {
+    return 0;
+}
+
+static struct ds3231_emul_data_st ds3231_emul_data;
+
+DEVICE_DT_DEFINE(DT_NODELABEL(ds3231), ds3231_emul_dev_init, NULL, NULL, NULL, POST_KERNEL, 
+        CONFIG_APPLICATION_INIT_PRIORITY, NULL);
+EMUL_DT_DEFINE(DT_NODELABEL(ds3231), ds3231_emul_init, &ds3231_emul_data, NULL, &ds3231_emul_api, 
+        NULL);
\ No newline at end of file
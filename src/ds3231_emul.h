@@ -0,0 +1,20 @@
+#ifndef _DS3231_EMUL_H_
+#define _DS3231_EMUL_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/drivers/emul.h>
+
+#define DS3231_EMUL_REG_COUNT 19                                                                    // 0x00-0x12
+
+struct ds3231_emul_data_st {
+    uint8_t regs[DS3231_EMUL_REG_COUNT];
+    uint8_t pointer;                                                                                // register pointer
+};
+
+static int ds3231_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs, 
+        int addr);
+static int ds3231_emul_init(const struct emul *target, const struct device *parent);
+
+#endif
\ No newline at end of file
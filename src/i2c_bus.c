@@ -0,0 +1,137 @@
+/*
+ * @brief This file shares an i2c bus between devices that want different speeds, 
+ *        the m24m02 streams at Fast-mode Plus (1 MHz) or Fast-mode (400 kHz), 
+ *        the ds3231 stays at Standard-mode (100 kHz). 
+ *        a device takes the bus with its speed, the bus is reconfigured 
+ *        only when the speed changes. 
+ *        nRF52832 TWI has no Fast-mode Plus, it falls back to Fast-mode there. 
+ */
+#include "i2c_bus.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(i2c_bus, LOG_LEVEL_ERR);
+
+K_MUTEX_DEFINE(i2c_bus_table_lock);
+
+/*
+ * @brief find the state of a bus, claim a free slot the first time
+ *
+ * @param dev i2c bus device
+ *
+ * @retval bus state, NULL if all slots are used
+ */
+static struct i2c_bus_st *i2c_bus_get(const struct device *dev) {
+    struct i2c_bus_st *bus = NULL;
+
+    k_mutex_lock(&i2c_bus_table_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(i2c_buses); i++) {
+        if (i2c_buses[i].dev == dev) {
+            bus = &i2c_buses[i];
+            break;
+        }
+
+        if (i2c_buses[i].dev == NULL) {
+            bus = &i2c_buses[i];
+            bus->dev = dev;
+            bus->speed = 0;
+            k_mutex_init(&bus->lock);
+            break;
+        }
+    }
+
+    k_mutex_unlock(&i2c_bus_table_lock);
+
+    return bus;
+}
+
+/*
+ * @brief reconfigure the bus if needed, caller holds bus->lock
+ *
+ * @param bus bus state
+ * @param speed I2C_SPEED_STANDARD, I2C_SPEED_FAST or I2C_SPEED_FAST_PLUS
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int i2c_bus_speed_apply(struct i2c_bus_st *bus, uint32_t speed) {
+    if (speed == I2C_SPEED_FAST_PLUS && bus->fast_plus_unsupported) {
+        speed = I2C_SPEED_FAST;
+    }
+
+    if (bus->speed == speed) {
+        return 0;
+    }
+
+    if (i2c_configure(bus->dev, I2C_SPEED_SET(speed) | I2C_MODE_CONTROLLER)) {
+        if (speed != I2C_SPEED_FAST_PLUS) {
+            LOG_ERR("i2c speed %d not supported!", speed);
+            return -1;
+        }
+
+        LOG_ERR("i2c Fast-mode Plus not supported, use Fast-mode!");
+        bus->fast_plus_unsupported = true;
+        return i2c_bus_speed_apply(bus, I2C_SPEED_FAST);
+    }
+
+    bus->speed = speed;
+
+    return 0;
+}
+
+/*
+ * @brief take a bus at a speed, i2c_bus_release() gives it back
+ *
+ * @param dev i2c bus device
+ * @param speed I2C_SPEED_STANDARD, I2C_SPEED_FAST or I2C_SPEED_FAST_PLUS
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, the bus is not taken
+ */
+int i2c_bus_acquire(const struct device *dev, uint32_t speed) {
+    struct i2c_bus_st *bus = i2c_bus_get(dev);
+
+    if (bus == NULL) {
+        return -1;
+    }
+
+    k_mutex_lock(&bus->lock, K_FOREVER);
+
+    if (i2c_bus_speed_apply(bus, speed)) {
+        k_mutex_unlock(&bus->lock);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief give a bus back
+ *
+ * @param dev i2c bus device
+ */
+void i2c_bus_release(const struct device *dev) {
+    struct i2c_bus_st *bus = i2c_bus_get(dev);
+
+    if (bus != NULL) {
+        k_mutex_unlock(&bus->lock);
+    }
+}
+
+/*
+ * @brief get the speed a bus is running at
+ *
+ * @param dev i2c bus device
+ *
+ * @retval I2C_SPEED_xx, 0 if not configured yet
+ */
+uint32_t i2c_bus_speed_get(const struct device *dev) {
+    struct i2c_bus_st *bus = i2c_bus_get(dev);
+
+    return bus == NULL ? 0 : bus->speed;
+}
\ No newline at end of file
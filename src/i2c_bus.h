@@ -0,0 +1,23 @@
+#ifndef _I2C_BUS_H_
+#define _I2C_BUS_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+
+#include "common.h"
+
+#define I2C_BUS_MAX 2                                                                               // i2c0 and i2c1
+
+struct i2c_bus_st {
+    const struct device *dev;
+    struct k_mutex lock;                                                                            // held for a transaction group
+    uint32_t speed;                                                                                 // I2C_SPEED_xx configured, 0: unknown
+    bool fast_plus_unsupported;
+};
+
+static struct i2c_bus_st i2c_buses[I2C_BUS_MAX];
+
+static struct i2c_bus_st *i2c_bus_get(const struct device *dev);
+static int i2c_bus_speed_apply(struct i2c_bus_st *bus, uint32_t speed);
+
+#endif
\ No newline at end of file
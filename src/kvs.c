@@ -0,0 +1,461 @@
+/*
+ * @brief This file is a log-structured key/value store for settings 
+ *        (watch face, brightness, last sync time ...) in the m24m02 KVS area. 
+ *        values are appended as records, a RAM index of the latest record of each key 
+ *        is rebuilt at boot, and live records are compacted into the other bank 
+ *        in the background once the active bank is 3/4 full. 
+ *        updating a key costs one small appended write spread over the whole bank, 
+ *        instead of a read-modify-write of one fixed page. 
+ */
+#include "kvs.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(kvs, LOG_LEVEL_ERR);
+
+K_MUTEX_DEFINE(kvs_lock);
+K_WORK_DEFINE(kvs_compact_work, kvs_compact_work_handler);
+K_THREAD_STACK_DEFINE(kvs_workq_stack, KVS_WORKQ_STACKSIZE);
+
+static struct k_work_q kvs_workq;
+
+static uint32_t kvs_bank_addr(uint8_t bank) {
+    return M24M02_KVS_ADDR + bank * KVS_BANK_SIZE;
+}
+
+static uint8_t kvs_record_crc(const struct kvs_record_header_st *header, const uint8_t *value) {
+    uint8_t crc = crc8_ccitt(0xFF, header, offsetof(struct kvs_record_header_st, crc));
+
+    return crc8_ccitt(crc, value, header->length);
+}
+
+/*
+ * @brief read the sequence number of a bank
+ *
+ * @param bank 0 or 1
+ * @param seq where the sequence number will be written to
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, no valid bank header
+ */
+static int kvs_bank_seq(uint8_t bank, uint32_t *seq) {
+    struct kvs_header_st header;
+
+    if (m24m02_read(kvs_bank_addr(bank), (uint8_t *)&header, sizeof(header))) {
+        return -1;
+    }
+
+    if (memcmp(header.magic, "kvs", sizeof(header.magic)) || header.version != KVS_VERSION) {
+        return -1;
+    }
+
+    *seq = header.seq;
+
+    return 0;
+}
+
+static struct kvs_index_st *kvs_index_get(uint16_t key) {
+    for (uint8_t i = 0; i < kvs_index_count; i++) {
+        if (kvs_index[i].key == key) {
+            return &kvs_index[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * @brief rebuild the RAM index from the active bank
+ *        scanning stops at the terminator or at a torn record (bad crc), 
+ *        which the next append overwrites. 
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int kvs_scan(void) {
+    uint32_t base = kvs_bank_addr(kvs_bank);
+    struct kvs_record_header_st header;
+
+    kvs_index_count = 0;
+    kvs_cursor = KVS_HEADER_SIZE;
+
+    while (kvs_cursor + KVS_RECORD_HEADER_SIZE + KVS_TERMINATOR_SIZE <= KVS_BANK_SIZE) {
+        if (m24m02_read(base + kvs_cursor, (uint8_t *)&header, sizeof(header))) {
+            return -1;
+        }
+
+        if (header.key == KVS_KEY_EMPTY || header.length > KVS_VALUE_SIZE_MAX) {                    // end
+            break;
+        }
+
+        if (m24m02_read(base + kvs_cursor + KVS_RECORD_HEADER_SIZE, kvs_value_buf, header.length)) {
+            return -1;
+        }
+
+        if (header.crc != kvs_record_crc(&header, kvs_value_buf)) {
+            LOG_ERR("torn record at 0x%.04x!", kvs_cursor);
+            break;
+        }
+
+        struct kvs_index_st *entry = kvs_index_get(header.key);
+        if (entry == NULL) {
+            if (kvs_index_count == KVS_KEY_MAX) {
+                LOG_ERR("kvs index full, key 0x%.04x dropped!", header.key);
+                kvs_cursor += KVS_RECORD_HEADER_SIZE + header.length;
+                continue;
+            }
+            entry = &kvs_index[kvs_index_count++];
+            entry->key = header.key;
+        }
+        entry->length = header.length;
+        entry->offset = kvs_cursor;
+
+        kvs_cursor += KVS_RECORD_HEADER_SIZE + header.length;
+    }
+
+    LOG_DBG("bank %d seq %u, %d keys, %d byte used...", kvs_bank, kvs_seq, kvs_index_count, kvs_cursor);
+
+    return 0;
+}
+
+/*
+ * @brief start an empty store in bank 0
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int kvs_format(void) {
+    struct kvs_header_st header = {
+        .magic = {'k', 'v', 's'}, 
+        .version = KVS_VERSION, 
+        .seq = 1, 
+    };
+
+    memcpy(kvs_record_buf, &header, sizeof(header));
+    memset(kvs_record_buf + sizeof(header), 0xFF, KVS_TERMINATOR_SIZE);
+
+    if (m24m02_write(kvs_bank_addr(0), kvs_record_buf, sizeof(header) + KVS_TERMINATOR_SIZE) 
+            || m24m02_cache_flush()) {
+        return -1;
+    }
+
+    kvs_bank = 0;
+    kvs_seq = header.seq;
+    kvs_cursor = KVS_HEADER_SIZE;
+    kvs_index_count = 0;
+
+    return 0;
+}
+
+/*
+ * @brief kvs init func, find the active bank and rebuild the RAM index
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int kvs_init(void) {
+    uint32_t seq[2];
+    bool valid[2];
+    int ret;
+
+    k_work_queue_start(&kvs_workq, kvs_workq_stack, K_THREAD_STACK_SIZEOF(kvs_workq_stack), 
+            KVS_WORKQ_PRIORITY, NULL);
+
+    k_mutex_lock(&kvs_lock, K_FOREVER);
+
+    valid[0] = !kvs_bank_seq(0, &seq[0]);
+    valid[1] = !kvs_bank_seq(1, &seq[1]);
+
+    if (!valid[0] && !valid[1]) {
+        LOG_DBG("no kvs found, format...");
+        ret = kvs_format();
+    } else {
+        kvs_bank = (valid[1] && (!valid[0] || seq[1] > seq[0])) ? 1 : 0;
+        kvs_seq = seq[kvs_bank];
+        ret = kvs_scan();
+    }
+
+    k_mutex_unlock(&kvs_lock);
+
+    return ret;
+}
+
+/*
+ * @brief append a record and its terminator to the active bank
+ *        compacts first if the bank is full, caller holds kvs_lock. 
+ *
+ * @param key key
+ * @param value value
+ * @param length value length, 0 deletes the key
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int kvs_append(uint16_t key, const uint8_t *value, uint8_t length) {
+    struct kvs_index_st *entry = kvs_index_get(key);
+    struct kvs_record_header_st header = {
+        .key = key, 
+        .length = length, 
+    };
+    size_t size = KVS_RECORD_HEADER_SIZE + length;
+
+    if (entry == NULL && kvs_index_count == KVS_KEY_MAX) {
+        LOG_ERR("kvs index full!");
+        return -1;
+    }
+
+    if (kvs_cursor + size + KVS_TERMINATOR_SIZE > KVS_BANK_SIZE) {
+        if (kvs_compact() || kvs_cursor + size + KVS_TERMINATOR_SIZE > KVS_BANK_SIZE) {
+            LOG_ERR("kvs full!");
+            return -1;
+        }
+        entry = kvs_index_get(key);                                                                 // index rebuilt
+    }
+
+    header.crc = kvs_record_crc(&header, value);
+    memcpy(kvs_record_buf, &header, sizeof(header));
+    memcpy(kvs_record_buf + sizeof(header), value, length);
+    memset(kvs_record_buf + size, 0xFF, KVS_TERMINATOR_SIZE);
+
+    if (m24m02_write(kvs_bank_addr(kvs_bank) + kvs_cursor, kvs_record_buf, size + KVS_TERMINATOR_SIZE) 
+            || m24m02_cache_flush()) {                                                              // on chip before the next record
+        return -1;
+    }
+
+    if (entry == NULL) {
+        entry = &kvs_index[kvs_index_count++];
+        entry->key = key;
+    }
+    entry->length = length;
+    entry->offset = kvs_cursor;
+
+    kvs_cursor += size;
+
+    if (kvs_cursor > KVS_COMPACT_THRESHOLD) {
+        k_work_submit_to_queue(&kvs_workq, &kvs_compact_work);
+    }
+
+    return 0;
+}
+
+/*
+ * @brief write a key
+ *        nothing is written if the stored value is the same. 
+ *
+ * @param key key, 0x0000-0xFFFE
+ * @param value value
+ * @param length value length, 1-KVS_VALUE_SIZE_MAX
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int kvs_write(uint16_t key, const void *value, uint8_t length) {
+    struct kvs_index_st *entry;
+    int ret;
+
+    if (key == KVS_KEY_EMPTY || length == 0 || length > KVS_VALUE_SIZE_MAX) {
+        return -1;
+    }
+
+    k_mutex_lock(&kvs_lock, K_FOREVER);
+
+    entry = kvs_index_get(key);
+    if (entry != NULL && entry->length == length) {
+        if (m24m02_read(kvs_bank_addr(kvs_bank) + entry->offset + KVS_RECORD_HEADER_SIZE, 
+                kvs_value_buf, length) == 0 && memcmp(kvs_value_buf, value, length) == 0) {
+            k_mutex_unlock(&kvs_lock);
+            return 0;                                                                               // unchanged
+        }
+    }
+
+    ret = kvs_append(key, value, length);
+
+    k_mutex_unlock(&kvs_lock);
+
+    return ret;
+}
+
+/*
+ * @brief read a key
+ *
+ * @param key key
+ * @param value where the value will be written to
+ * @param length value buffer length
+ *
+ * @retval byte read
+ * @retval -1 failed, key not found
+ */
+int kvs_read(uint16_t key, void *value, uint8_t length) {
+    struct kvs_index_st *entry;
+    int ret = -1;
+
+    k_mutex_lock(&kvs_lock, K_FOREVER);
+
+    entry = kvs_index_get(key);
+    if (entry != NULL && entry->length > 0) {
+        length = MIN(length, entry->length);
+        if (m24m02_read(kvs_bank_addr(kvs_bank) + entry->offset + KVS_RECORD_HEADER_SIZE, 
+                value, length) == 0) {
+            ret = length;
+        }
+    }
+
+    k_mutex_unlock(&kvs_lock);
+
+    return ret;
+}
+
+/*
+ * @brief delete a key
+ *
+ * @param key key
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int kvs_delete(uint16_t key) {
+    struct kvs_index_st *entry;
+    int ret = 0;
+
+    k_mutex_lock(&kvs_lock, K_FOREVER);
+
+    entry = kvs_index_get(key);
+    if (entry != NULL && entry->length > 0) {
+        ret = kvs_append(key, NULL, 0);
+    }
+
+    k_mutex_unlock(&kvs_lock);
+
+    return ret;
+}
+
+/*
+ * @brief put compacted bytes into the page buffer, program it when full
+ */
+static int kvs_compact_put(const uint8_t *data, size_t length) {
+    while (length > 0) {
+        size_t chunk = MIN(length, KVS_PAGE_SIZE - kvs_compact_fill);
+
+        memcpy(kvs_compact_buf + kvs_compact_fill, data, chunk);
+        kvs_compact_fill += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (kvs_compact_fill == KVS_PAGE_SIZE && kvs_compact_flush()) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * @brief program the filled part of the page buffer, one write cycle
+ */
+static int kvs_compact_flush(void) {
+    if (kvs_compact_fill > kvs_compact_start) {
+        if (m24m02_write(kvs_compact_addr + kvs_compact_start, kvs_compact_buf + kvs_compact_start, 
+                kvs_compact_fill - kvs_compact_start)) {
+            return -1;
+        }
+    }
+
+    kvs_compact_addr += KVS_PAGE_SIZE;
+    kvs_compact_start = 0;
+    kvs_compact_fill = 0;
+
+    return 0;
+}
+
+/*
+ * @brief copy live records into the other bank page by page, 
+ *        then write its header with the next seq, which makes it active. 
+ *        the page cache is flushed around the header, so a write-back cache 
+ *        can't program it before the records. 
+ *        deleted keys are dropped. caller holds kvs_lock. 
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, the old bank stays active
+ */
+static int kvs_compact(void) {
+    uint8_t bank = kvs_bank ^ 1;
+    uint16_t offset[KVS_KEY_MAX];
+    uint16_t cursor = KVS_HEADER_SIZE;
+    uint8_t terminator[KVS_TERMINATOR_SIZE] = {0xFF, 0xFF};
+    struct kvs_header_st header = {
+        .magic = {'k', 'v', 's'}, 
+        .version = KVS_VERSION, 
+        .seq = kvs_seq + 1, 
+    };
+
+    kvs_compact_addr = kvs_bank_addr(bank);                                                         // page aligned
+    kvs_compact_start = KVS_HEADER_SIZE;                                                            // header goes last
+    kvs_compact_fill = KVS_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < kvs_index_count; i++) {
+        struct kvs_record_header_st record = {
+            .key = kvs_index[i].key, 
+            .length = kvs_index[i].length, 
+        };
+
+        if (record.length == 0) {
+            continue;
+        }
+
+        if (m24m02_read(kvs_bank_addr(kvs_bank) + kvs_index[i].offset + KVS_RECORD_HEADER_SIZE, 
+                kvs_value_buf, record.length)) {
+            return -1;
+        }
+        record.crc = kvs_record_crc(&record, kvs_value_buf);
+
+        if (kvs_compact_put((uint8_t *)&record, sizeof(record)) 
+                || kvs_compact_put(kvs_value_buf, record.length)) {
+            return -1;
+        }
+
+        offset[i] = cursor;
+        cursor += KVS_RECORD_HEADER_SIZE + record.length;
+    }
+
+    if (kvs_compact_put(terminator, sizeof(terminator)) || kvs_compact_flush() 
+            || m24m02_cache_flush()) {                                                              // records land before the header
+        return -1;
+    }
+
+    if (m24m02_write(kvs_bank_addr(bank), (uint8_t *)&header, sizeof(header))                       // commit
+            || m24m02_cache_flush()) {
+        return -1;
+    }
+
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < kvs_index_count; i++) {
+        if (kvs_index[i].length > 0) {
+            kvs_index[count] = kvs_index[i];
+            kvs_index[count].offset = offset[i];
+            count++;
+        }
+    }
+
+    kvs_index_count = count;
+    kvs_bank = bank;
+    kvs_seq = header.seq;
+    kvs_cursor = cursor;
+
+    LOG_DBG("compacted into bank %d, %d keys, %d byte used...", kvs_bank, kvs_index_count, kvs_cursor);
+
+    return 0;
+}
+
+static void kvs_compact_work_handler(struct k_work *work) {
+    k_mutex_lock(&kvs_lock, K_FOREVER);
+
+    if (kvs_cursor > KVS_COMPACT_THRESHOLD && kvs_compact()) {
+        LOG_ERR("kvs compaction failed!");
+    }
+
+    k_mutex_unlock(&kvs_lock);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef _KVS_H_
+#define _KVS_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define KVS_BANK_SIZE (M24M02_KVS_SIZE / 2)                                                         // 2 banks, used in turn
+#define KVS_HEADER_SIZE 8
+#define KVS_RECORD_HEADER_SIZE 4
+#define KVS_TERMINATOR_SIZE 2
+#define KVS_KEY_EMPTY 0xFFFF                                                                        // unwritten m24m02 reads 0xFF
+#define KVS_KEY_MAX 32                                                                              // keys in RAM index
+#define KVS_COMPACT_THRESHOLD (KVS_BANK_SIZE * 3 / 4)                                               // start background compaction
+#define KVS_PAGE_SIZE 256
+#define KVS_WORKQ_STACKSIZE 1024
+#define KVS_WORKQ_PRIORITY 10                                                                       // background compaction
+
+/*
+ * @brief bank layout, little endian
+ *        +-------+---------+-----+----------+-----+----------+--------+
+ *        | "kvs" | version | seq | record 0 | ... | record n | 0xFFFF |
+ *        +-------+---------+-----+----------+-----+----------+--------+
+ *        record - key (2 byte), length (1 byte), crc8 (1 byte), value (length byte), 
+ *        length 0 deletes the key. 
+ *        every append also writes the 0xFFFF terminator behind the record, 
+ *        so stale records behind the end are never parsed and banks never need erasing. 
+ *        the bank with the highest seq is active, a compacted bank becomes active 
+ *        when its header is written last. 
+ */
+struct kvs_header_st {
+    uint8_t magic[3];                                                                               // ASCII "kvs"
+    uint8_t version;
+    uint32_t seq;
+} __packed;
+
+struct kvs_record_header_st {
+    uint16_t key;
+    uint8_t length;
+    uint8_t crc;                                                                                    // crc8 of key, length, value
+} __packed;
+
+struct kvs_index_st {
+    uint16_t key;
+    uint8_t length;                                                                                 // 0: deleted
+    uint16_t offset;                                                                                // record offset in bank
+};
+
+#define KVS_VERSION 0x01
+
+static struct kvs_index_st kvs_index[KVS_KEY_MAX];                                                  // latest record of each key
+static uint8_t kvs_index_count;
+static uint8_t kvs_bank;                                                                            // active bank
+static uint32_t kvs_seq;
+static uint16_t kvs_cursor;                                                                         // append offset in bank
+
+static uint8_t kvs_record_buf[KVS_RECORD_HEADER_SIZE + KVS_VALUE_SIZE_MAX + KVS_TERMINATOR_SIZE];
+static uint8_t kvs_value_buf[KVS_VALUE_SIZE_MAX];
+static uint8_t kvs_compact_buf[KVS_PAGE_SIZE];
+static uint32_t kvs_compact_addr;                                                                   // address of kvs_compact_buf[0]
+static uint16_t kvs_compact_start;                                                                  // first byte to program
+static uint16_t kvs_compact_fill;
+
+static uint32_t kvs_bank_addr(uint8_t bank);
+static uint8_t kvs_record_crc(const struct kvs_record_header_st *header, const uint8_t *value);
+static int kvs_bank_seq(uint8_t bank, uint32_t *seq);
+static int kvs_scan(void);
+static int kvs_format(void);
+static struct kvs_index_st *kvs_index_get(uint16_t key);
+static int kvs_append(uint16_t key, const uint8_t *value, uint8_t length);
+static int kvs_compact(void);
+static int kvs_compact_put(const uint8_t *data, size_t length);
+static int kvs_compact_flush(void);
+static void kvs_compact_work_handler(struct k_work *work);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+ * @brief This file measures m24m02 throughput at each i2c speed, 
+ *        sequential read (one M24M02_BENCH_READ_SIZE burst) 
+ *        and page write (M24M02_BENCH_WRITE_PAGES pages, ACK polled). 
+ *        the written pages are read first and written back unchanged, 
+ *        so the benchmark does not destroy data, it costs one write cycle per page. 
+ */
+#include "m24m02_bench.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_bench, LOG_LEVEL_DBG);
+
+/*
+ * @brief byte/s since start
+ */
+static uint32_t m24m02_bench_rate(size_t bytes, uint32_t start) {
+    uint32_t elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    return elapsed_us ? (uint64_t)bytes * USEC_PER_SEC / elapsed_us : 0;
+}
+
+/*
+ * @brief measure at one speed
+ *
+ * @param speed I2C_SPEED_xx requested
+ * @param result where the result will be written to
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int m24m02_bench_run(uint32_t speed, struct m24m02_bench_st *result) {
+    uint32_t start;
+
+    m24m02_bus_speed_set(speed);
+
+    if (m24m02_bus_read(M24M02_BENCH_ADDR, m24m02_bench_buf, sizeof(m24m02_bench_buf))) {           // also applies the speed
+        return -1;
+    }
+
+    result->speed = speed;
+    result->applied_speed = m24m02_bus_speed_get();
+
+    start = k_cycle_get_32();
+    for (size_t done = 0; done < M24M02_BENCH_READ_SIZE; done += sizeof(m24m02_bench_buf)) {
+        if (m24m02_bus_read(M24M02_BENCH_ADDR + done, m24m02_bench_buf, sizeof(m24m02_bench_buf))) {
+            return -1;
+        }
+    }
+    result->read_bytes_per_s = m24m02_bench_rate(M24M02_BENCH_READ_SIZE, start);
+
+    if (m24m02_bus_read(M24M02_BENCH_ADDR, m24m02_bench_buf, sizeof(m24m02_bench_buf))) {           // content to write back
+        return -1;
+    }
+
+    start = k_cycle_get_32();
+    if (m24m02_bus_write(M24M02_BENCH_ADDR, m24m02_bench_buf, sizeof(m24m02_bench_buf))) {
+        return -1;
+    }
+    result->write_bytes_per_s = m24m02_bench_rate(sizeof(m24m02_bench_buf), start);
+
+    LOG_DBG("speed %d (runs at %d): read %u byte/s, page write %u byte/s", speed, 
+            result->applied_speed, result->read_bytes_per_s, result->write_bytes_per_s);
+
+    return 0;
+}
+
+/*
+ * @brief run the benchmark at standard, fast and fast plus speed
+ *        the page cache is flushed first, the configured speed is restored after. 
+ *
+ * @param results where 3 results will be written to, may be NULL
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_bench(struct m24m02_bench_st *results) {
+    const uint32_t speeds[] = {I2C_SPEED_STANDARD, I2C_SPEED_FAST, I2C_SPEED_FAST_PLUS};
+    uint32_t speed = m24m02_bus_speed_set(I2C_SPEED_STANDARD);
+    int ret = 0;
+
+    if (m24m02_cache_flush()) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(speeds); i++) {
+        if (m24m02_bench_run(speeds[i], &m24m02_bench_results[i])) {
+            LOG_ERR("benchmark at speed %d failed!", speeds[i]);
+            ret = -1;
+            break;
+        }
+    }
+
+    m24m02_bus_speed_set(speed);
+
+    if (results != NULL) {
+        memcpy(results, m24m02_bench_results, sizeof(m24m02_bench_results));
+    }
+
+    return ret;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef _M24M02_BENCH_H_
+#define _M24M02_BENCH_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define M24M02_BENCH_ADDR 0x00000                                                                   // read, then rewritten unchanged
+#define M24M02_BENCH_READ_SIZE 8192                                                                 // one read burst
+#define M24M02_BENCH_WRITE_PAGES 16
+#define M24M02_BENCH_PAGE_SIZE 256
+
+static uint8_t m24m02_bench_buf[M24M02_BENCH_PAGE_SIZE * M24M02_BENCH_WRITE_PAGES];
+static struct m24m02_bench_st m24m02_bench_results[3];                                              // standard, fast, fast plus
+
+static uint32_t m24m02_bench_rate(size_t bytes, uint32_t start);
+static int m24m02_bench_run(uint32_t speed, struct m24m02_bench_st *result);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,326 @@
+/*
+ * @brief This file keeps recently used m24m02 pages in RAM (LRU), 
+ *        so repeated glyph and background fetches do not go to the i2c bus. 
+ *        cache size is CONFIG_M24M02_CACHE_PAGES, write policy is write-through, 
+ *        or write-back with CONFIG_M24M02_CACHE_WRITE_BACK. 
+ *        the cache lock is held per page, so threads sharing the cache interleave. 
+ */
+#include "m24m02_cache.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_cache, LOG_LEVEL_ERR);
+
+#if CONFIG_M24M02_CACHE_PAGES > 0
+
+K_MUTEX_DEFINE(m24m02_cache_lock);
+
+/*
+ * @brief find a cached page, refresh its LRU stamp
+ *
+ * @param page A17-A8 address
+ *
+ * @retval cache line, NULL if not cached
+ */
+static struct m24m02_cache_line_st *m24m02_cache_lookup(uint32_t page) {
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_cache_lines); i++) {
+        if (m24m02_cache_lines[i].valid && m24m02_cache_lines[i].page == page) {
+            m24m02_cache_lines[i].last_used = ++m24m02_cache_clock;
+            return &m24m02_cache_lines[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * @brief program the dirty span of a cache line
+ *
+ * @param line cache line
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int m24m02_cache_line_flush(struct m24m02_cache_line_st *line) {
+    if (!line->valid || !line->dirty) {
+        return 0;
+    }
+
+    if (m24m02_bus_write(line->page * M24M02_CACHE_PAGE_SIZE + line->dirty_start, 
+            line->data + line->dirty_start, line->dirty_end - line->dirty_start)) {
+        return -1;
+    }
+
+    line->dirty = false;
+    m24m02_cache_stats.write_backs++;
+
+    return 0;
+}
+
+/*
+ * @brief take the least recently used line (or a free one) for a page
+ *
+ * @param page A17-A8 address
+ * @param fill true: read the page from bus, false: caller overwrites the whole page
+ *
+ * @retval cache line, NULL if failed
+ */
+static struct m24m02_cache_line_st *m24m02_cache_load(uint32_t page, bool fill) {
+    struct m24m02_cache_line_st *line = &m24m02_cache_lines[0];
+
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_cache_lines); i++) {
+        if (!m24m02_cache_lines[i].valid) {
+            line = &m24m02_cache_lines[i];
+            break;
+        }
+        if (m24m02_cache_lines[i].last_used < line->last_used) {
+            line = &m24m02_cache_lines[i];
+        }
+    }
+
+    if (line->valid) {
+        if (m24m02_cache_line_flush(line)) {
+            return NULL;
+        }
+        m24m02_cache_stats.evictions++;
+        line->valid = false;
+    }
+
+    if (fill && m24m02_bus_read(page * M24M02_CACHE_PAGE_SIZE, line->data, M24M02_CACHE_PAGE_SIZE)) {
+        return NULL;
+    }
+
+    line->page = page;
+    line->dirty = false;
+    line->valid = true;
+    line->last_used = ++m24m02_cache_clock;
+
+    return line;
+}
+
+/*
+ * @brief read from the bus, patched with dirty cached pages, no line is allocated
+ *        for one-off reads (streams, compare reads) that must not evict hot pages. 
+ *
+ * @param addr A17-A0 address
+ * @param buf where data will be written to
+ * @param length data length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_cache_peek(uint32_t addr, uint8_t *buf, size_t length) {
+    k_mutex_lock(&m24m02_cache_lock, K_FOREVER);                                                    // no flush between read and patch
+
+    if (m24m02_bus_read(addr, buf, length)) {
+        k_mutex_unlock(&m24m02_cache_lock);
+        return -1;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_cache_lines); i++) {                                   // cached data is newer
+        struct m24m02_cache_line_st *line = &m24m02_cache_lines[i];
+        uint32_t start = MAX(addr, line->page * M24M02_CACHE_PAGE_SIZE);
+        uint32_t end = MIN(addr + length, (line->page + 1) * M24M02_CACHE_PAGE_SIZE);
+
+        if (line->valid && line->dirty && start < end) {
+            memcpy(buf + (start - addr), 
+                    line->data + (start % M24M02_CACHE_PAGE_SIZE), end - start);
+        }
+    }
+
+    m24m02_cache_stats.bypasses++;
+
+    k_mutex_unlock(&m24m02_cache_lock);
+
+    return 0;
+}
+
+/*
+ * @brief read through the page cache
+ *        reads larger than the whole cache go to the bus in one burst and are 
+ *        patched with cached pages, so streaming an asset does not evict the cache. 
+ *
+ * @param addr A17-A0 address
+ * @param buf where data will be written to
+ * @param length data length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_cache_read(uint32_t addr, uint8_t *buf, size_t length) {
+    if (length > ARRAY_SIZE(m24m02_cache_lines) * M24M02_CACHE_PAGE_SIZE) {
+        return m24m02_cache_peek(addr, buf, length);
+    }
+
+    while (length > 0) {
+        uint32_t page = addr / M24M02_CACHE_PAGE_SIZE;
+        size_t offset = addr % M24M02_CACHE_PAGE_SIZE;
+        size_t chunk = MIN(length, M24M02_CACHE_PAGE_SIZE - offset);
+        struct m24m02_cache_line_st *line;
+
+        k_mutex_lock(&m24m02_cache_lock, K_FOREVER);
+
+        line = m24m02_cache_lookup(page);
+        if (line != NULL) {
+            m24m02_cache_stats.hits++;
+        } else {
+            m24m02_cache_stats.misses++;
+            line = m24m02_cache_load(page, true);
+            if (line == NULL) {
+                k_mutex_unlock(&m24m02_cache_lock);
+                return -1;
+            }
+        }
+
+        memcpy(buf, line->data + offset, chunk);
+
+        k_mutex_unlock(&m24m02_cache_lock);
+
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief write through the page cache
+ *        write-through: cached pages are updated, data is programmed at once. 
+ *        write-back: data lands in the cache, the dirty span is programmed on 
+ *        eviction or m24m02_cache_flush(). 
+ *
+ * @param addr A17-A0 address
+ * @param buf data buffer
+ * @param length data length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_cache_write(uint32_t addr, uint8_t *buf, size_t length) {
+    while (length > 0) {
+        uint32_t page = addr / M24M02_CACHE_PAGE_SIZE;
+        size_t offset = addr % M24M02_CACHE_PAGE_SIZE;
+        size_t chunk = MIN(length, M24M02_CACHE_PAGE_SIZE - offset);
+        struct m24m02_cache_line_st *line;
+
+        k_mutex_lock(&m24m02_cache_lock, K_FOREVER);
+
+        line = m24m02_cache_lookup(page);
+
+#if CONFIG_M24M02_CACHE_WRITE_BACK
+        if (line == NULL) {
+            line = m24m02_cache_load(page, chunk != M24M02_CACHE_PAGE_SIZE);                        // full page need not be read
+            if (line == NULL) {
+                k_mutex_unlock(&m24m02_cache_lock);
+                return -1;
+            }
+        }
+
+        memcpy(line->data + offset, buf, chunk);
+
+        if (line->dirty) {
+            line->dirty_start = MIN(line->dirty_start, offset);
+            line->dirty_end = MAX(line->dirty_end, offset + chunk);
+        } else {
+            line->dirty_start = offset;
+            line->dirty_end = offset + chunk;
+            line->dirty = true;
+        }
+#else
+        if (line != NULL) {
+            memcpy(line->data + offset, buf, chunk);
+        }
+
+        if (m24m02_bus_write(addr, buf, chunk)) {
+            if (line != NULL) {
+                line->valid = false;
+            }
+            k_mutex_unlock(&m24m02_cache_lock);
+            return -1;
+        }
+#endif
+
+        k_mutex_unlock(&m24m02_cache_lock);
+
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief program all dirty pages
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_cache_flush(void) {
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_cache_lines); i++) {
+        k_mutex_lock(&m24m02_cache_lock, K_FOREVER);
+        int ret = m24m02_cache_line_flush(&m24m02_cache_lines[i]);
+        k_mutex_unlock(&m24m02_cache_lock);
+
+        if (ret) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * @brief drop all cached pages, dirty data is lost
+ */
+void m24m02_cache_invalidate(void) {
+    k_mutex_lock(&m24m02_cache_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_cache_lines); i++) {
+        m24m02_cache_lines[i].valid = false;
+    }
+
+    k_mutex_unlock(&m24m02_cache_lock);
+}
+
+/*
+ * @brief get cache statistics
+ *
+ * @param stats where statistics will be copied to
+ */
+void m24m02_cache_stats_get(struct m24m02_cache_stats_st *stats) {
+    k_mutex_lock(&m24m02_cache_lock, K_FOREVER);
+    *stats = m24m02_cache_stats;
+    k_mutex_unlock(&m24m02_cache_lock);
+}
+
+#else
+
+int m24m02_cache_peek(uint32_t addr, uint8_t *buf, size_t length) {
+    return m24m02_bus_read(addr, buf, length);
+}
+
+int m24m02_cache_read(uint32_t addr, uint8_t *buf, size_t length) {
+    return m24m02_bus_read(addr, buf, length);
+}
+
+int m24m02_cache_write(uint32_t addr, uint8_t *buf, size_t length) {
+    return m24m02_bus_write(addr, buf, length);
+}
+
+int m24m02_cache_flush(void) {
+    return 0;
+}
+
+void m24m02_cache_invalidate(void) {
+}
+
+void m24m02_cache_stats_get(struct m24m02_cache_stats_st *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef _M24M02_CACHE_H_
+#define _M24M02_CACHE_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define M24M02_CACHE_PAGE_SIZE 256
+
+struct m24m02_cache_line_st {
+    uint32_t page;                                                                                  // A17-A8
+    uint32_t last_used;                                                                             // LRU stamp
+    uint16_t dirty_start;                                                                           // dirty span [start, end)
+    uint16_t dirty_end;
+    bool valid;
+    bool dirty;
+    uint8_t data[M24M02_CACHE_PAGE_SIZE];
+};
+
+#if CONFIG_M24M02_CACHE_PAGES > 0
+
+static struct m24m02_cache_line_st m24m02_cache_lines[CONFIG_M24M02_CACHE_PAGES];
+static uint32_t m24m02_cache_clock;
+static struct m24m02_cache_stats_st m24m02_cache_stats;
+
+static struct m24m02_cache_line_st *m24m02_cache_lookup(uint32_t page);
+static struct m24m02_cache_line_st *m24m02_cache_load(uint32_t page, bool fill);
+static int m24m02_cache_line_flush(struct m24m02_cache_line_st *line);
+
+#endif
+
+#endif
\ No newline at end of file
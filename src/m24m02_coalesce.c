@@ -0,0 +1,209 @@
+/*
+ * @brief This file gathers small adjacent m24m02 writes (settings, BLE chunks) 
+ *        of one page in RAM and programs them as one page write, 
+ *        on page change, when the page is complete, on timeout or on explicit flush. 
+ *        two page buffers are used, one gathers while the other is programmed 
+ *        by the m24m02 queue thread. nothing here waits for a write cycle, 
+ *        when both buffers are busy a write fails at once, so BT RX is never blocked. 
+ */
+#include "m24m02_coalesce.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_coalesce, LOG_LEVEL_ERR);
+
+K_MUTEX_DEFINE(m24m02_coalesce_lock);
+K_WORK_DELAYABLE_DEFINE(m24m02_coalesce_timeout_work, m24m02_coalesce_timeout);
+
+/*
+ * @brief coalescing init func
+ *
+ * @retval 0 succeed
+ */
+int m24m02_coalesce_init(void) {
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_coalesce_bufs); i++) {
+        k_sem_init(&m24m02_coalesce_bufs[i].idle, 1, 1);
+        m24m02_coalesce_bufs[i].used = false;
+    }
+
+    m24m02_coalesce_curr = 0;
+
+    return 0;
+}
+
+/*
+ * @brief page buffer programmed, it can gather again
+ */
+static void m24m02_coalesce_written(int result, uint32_t addr, uint8_t *buf, size_t length, 
+        void *user_data) {
+    struct m24m02_coalesce_buf_st *cbuf = user_data;
+
+    if (result) {
+        LOG_ERR("coalesced write 0x%.05x, %d byte failed!", addr, length);
+        k_mutex_lock(&m24m02_coalesce_lock, K_FOREVER);
+        m24m02_coalesce_stats.errors++;
+        k_mutex_unlock(&m24m02_coalesce_lock);
+    }
+
+    k_sem_give(&cbuf->idle);
+}
+
+/*
+ * @brief hand the gathering buffer to the m24m02 queue, switch to the other one
+ *        caller holds m24m02_coalesce_lock. 
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, or the other buffer is still being programmed
+ */
+static int m24m02_coalesce_submit(void) {
+    struct m24m02_coalesce_buf_st *cbuf = &m24m02_coalesce_bufs[m24m02_coalesce_curr];
+
+    if (!cbuf->used) {
+        return 0;
+    }
+
+    if (k_sem_take(&cbuf->idle, K_NO_WAIT)) {                                                       // busy until written
+        return -1;
+    }
+
+    if (m24m02_write_async(cbuf->page * M24M02_COALESCE_PAGE_SIZE + cbuf->start, 
+            cbuf->data + cbuf->start, cbuf->end - cbuf->start, m24m02_coalesce_written, cbuf)) {
+        k_sem_give(&cbuf->idle);
+        return -1;
+    }
+
+    cbuf->used = false;
+    m24m02_coalesce_stats.page_writes++;
+    m24m02_coalesce_curr ^= 1;
+
+    return 0;
+}
+
+/*
+ * @brief no write for M24M02_COALESCE_TIMEOUT_MS, program the gathered page
+ */
+static void m24m02_coalesce_timeout(struct k_work *work) {
+    k_mutex_lock(&m24m02_coalesce_lock, K_FOREVER);
+    if (m24m02_coalesce_submit()) {
+        k_work_reschedule(&m24m02_coalesce_timeout_work, K_MSEC(M24M02_COALESCE_TIMEOUT_MS));       // queue full, retry
+    }
+    k_mutex_unlock(&m24m02_coalesce_lock);
+}
+
+/*
+ * @brief coalesced write, data is copied, so buf can be reused at once
+ *        fails when both page buffers are being programmed, 
+ *        the caller retries later (BT: ATT insufficient resources). 
+ *
+ * @param addr A17-A0 address
+ * @param buf data buffer
+ * @param length data length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_coalesce_write(uint32_t addr, const uint8_t *buf, size_t length) {
+    if (addr > M24M02_SIZE || length > M24M02_SIZE - addr) {
+        LOG_ERR("no enough space!");
+        return -1;
+    }
+
+    k_mutex_lock(&m24m02_coalesce_lock, K_FOREVER);
+
+    m24m02_coalesce_stats.writes++;
+
+    while (length > 0) {
+        uint32_t page = addr / M24M02_COALESCE_PAGE_SIZE;
+        uint16_t offset = addr % M24M02_COALESCE_PAGE_SIZE;
+        size_t chunk = MIN(length, M24M02_COALESCE_PAGE_SIZE - offset);
+        struct m24m02_coalesce_buf_st *cbuf = &m24m02_coalesce_bufs[m24m02_coalesce_curr];
+
+        if (cbuf->used && (cbuf->page != page || offset > cbuf->end 
+                || offset + chunk < cbuf->start)) {                                                 // not adjacent
+            if (m24m02_coalesce_submit()) {
+                k_mutex_unlock(&m24m02_coalesce_lock);
+                return -1;
+            }
+            cbuf = &m24m02_coalesce_bufs[m24m02_coalesce_curr];
+        }
+
+        if (!cbuf->used) {
+            if (k_sem_take(&cbuf->idle, K_NO_WAIT)) {                                               // previous write not landed
+                k_mutex_unlock(&m24m02_coalesce_lock);
+                return -1;
+            }
+            k_sem_give(&cbuf->idle);
+            cbuf->page = page;
+            cbuf->start = offset;
+            cbuf->end = offset + chunk;
+            cbuf->used = true;
+        } else {
+            cbuf->start = MIN(cbuf->start, offset);
+            cbuf->end = MAX(cbuf->end, offset + chunk);
+        }
+
+        memcpy(cbuf->data + offset, buf, chunk);
+
+        if (cbuf->start == 0 && cbuf->end == M24M02_COALESCE_PAGE_SIZE) {                           // page complete
+            if (m24m02_coalesce_submit()) {
+                k_mutex_unlock(&m24m02_coalesce_lock);
+                return -1;
+            }
+        }
+
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
+
+    k_work_reschedule(&m24m02_coalesce_timeout_work, K_MSEC(M24M02_COALESCE_TIMEOUT_MS));
+
+    k_mutex_unlock(&m24m02_coalesce_lock);
+
+    return 0;
+}
+
+/*
+ * @brief program the gathered page and wait until every coalesced write landed
+ *        waits for write cycles, do not call it from BT callbacks. 
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_coalesce_flush(void) {
+    k_work_cancel_delayable(&m24m02_coalesce_timeout_work);
+
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_coalesce_bufs); i++) {                                 // other buffer may be busy
+        k_sem_take(&m24m02_coalesce_bufs[i].idle, K_FOREVER);
+        k_sem_give(&m24m02_coalesce_bufs[i].idle);
+    }
+
+    k_mutex_lock(&m24m02_coalesce_lock, K_FOREVER);
+    int ret = m24m02_coalesce_submit();
+    k_mutex_unlock(&m24m02_coalesce_lock);
+
+    if (ret) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_coalesce_bufs); i++) {                                 // without the lock
+        k_sem_take(&m24m02_coalesce_bufs[i].idle, K_FOREVER);
+        k_sem_give(&m24m02_coalesce_bufs[i].idle);
+    }
+
+    return 0;
+}
+
+/*
+ * @brief get coalescing statistics
+ *
+ * @param stats where statistics will be copied to
+ */
+void m24m02_coalesce_stats_get(struct m24m02_coalesce_stats_st *stats) {
+    k_mutex_lock(&m24m02_coalesce_lock, K_FOREVER);
+    *stats = m24m02_coalesce_stats;
+    k_mutex_unlock(&m24m02_coalesce_lock);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef _M24M02_COALESCE_H_
+#define _M24M02_COALESCE_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define M24M02_COALESCE_PAGE_SIZE 256
+#define M24M02_COALESCE_TIMEOUT_MS 200                                                              // flush an idle page after
+
+struct m24m02_coalesce_buf_st {
+    uint32_t page;                                                                                  // A17-A8
+    uint16_t start;                                                                                 // gathered span [start, end)
+    uint16_t end;
+    bool used;
+    struct k_sem idle;                                                                              // no write in flight
+    uint8_t data[M24M02_COALESCE_PAGE_SIZE];
+};
+
+static struct m24m02_coalesce_buf_st m24m02_coalesce_bufs[2];                                       // gather one, program the other
+static uint8_t m24m02_coalesce_curr;
+static struct m24m02_coalesce_stats_st m24m02_coalesce_stats;
+
+static void m24m02_coalesce_timeout(struct k_work *work);
+static void m24m02_coalesce_written(int result, uint32_t addr, uint8_t *buf, size_t length, 
+        void *user_data);
+static int m24m02_coalesce_submit(void);
+
+#endif
\ No newline at end of file
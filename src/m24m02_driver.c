@@ -13,24 +13,34 @@ LOG_MODULE_REGISTER(m24m02, LOG_LEVEL_ERR);
  *        A0-A17 address bits, 2 ^ 8 * 2 ^ 10 = 256K, 
  *        each address bit corresponding 1 byte data, 
  *        256K * 8 bit = 2Mbit. 
+ *        it answers at 4 device select codes (0x50-0x53, A17-A16), each can be regarded 
+ *        as 512Kbit memory, plus 0x58 for the Identification Page (256 byte). 
+ *        chips come from devicetree (compatible "cubewatch,m24xx") and are joined 
+ *        into one linear address space in devicetree order. 
  */
-static const struct i2c_dt_spec m24m02a_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(m24m02a));
-/*
- * @brief m24m02b (same as m24m02a, m24m02c, m24m02d) can be regarded as 512Kbit memory, 
- *        A0-A15 address bits, 2 ^ 6 * 2 ^ 10 = 64K, 
- *        each address bit corresponding 1 byte data, 
- *        64K * 8 bit = 512Kbit. 
- */
-static const struct i2c_dt_spec m24m02b_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(m24m02b));
-static const struct i2c_dt_spec m24m02c_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(m24m02c));
-static const struct i2c_dt_spec m24m02d_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(m24m02d));
-/*
- * @brief m24m02e is the Identification Page (256 byte), 
- *        A0-A7 address bit, 2 ^ 8 = 256, 
- *        each address bit corresponding 1 byte data, 
- *        256 * 8 bit = 256 byte. 
- */
-static const struct i2c_dt_spec m24m02e_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(m24m02e));
+#define M24M02_CTX_DEFINE(inst) \
+    { \
+        .config = { \
+            .bus = DEVICE_DT_GET(DT_INST_BUS(inst)), \
+            .addr = DT_INST_REG_ADDR(inst), \
+            .addr_step = DT_INST_PROP(inst, block_addr_step), \
+            .id_addr = DT_INST_PROP(inst, id_page_addr), \
+            .size = DT_INST_PROP(inst, size), \
+            .block_size = DT_INST_PROP(inst, size) / DT_INST_PROP(inst, block_count), \
+            .page_size = DT_INST_PROP(inst, pagesize), \
+            .block_count = DT_INST_PROP(inst, block_count), \
+            .read_across_blocks = DT_INST_PROP(inst, read_across_blocks), \
+        }, \
+    },
+
+static struct m24m02_ctx_st m24m02_ctxs[] = {
+    DT_INST_FOREACH_STATUS_OKAY(M24M02_CTX_DEFINE)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(m24m02_ctxs) > 0, "no cubewatch,m24xx node in devicetree");
+
+K_MUTEX_DEFINE(m24m02_diff_lock);
+K_MUTEX_DEFINE(m24m02_fill_lock);
 
 /*
  * @brief m24m02 init function
@@ -39,324 +49,370 @@ static const struct i2c_dt_spec m24m02e_i2c = I2C_DT_SPEC_GET(DT_NODELABEL(m24m0
  * @retval -1 failed
  */
 int m24m02_init(void) {
+    uint32_t base = 0;
 
-    if(!device_is_ready(m24m02a_i2c.bus)) {
-        return -1;
-    }
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_ctxs); i++) {
+        struct m24m02_ctx_st *ctx = &m24m02_ctxs[i];
 
-    if(!device_is_ready(m24m02b_i2c.bus)) {
-        return -1;
-    }
+        if(!device_is_ready(ctx->config.bus)) {
+            return -1;
+        }
 
-    if(!device_is_ready(m24m02c_i2c.bus)) {
-        return -1;
+        k_mutex_init(&ctx->lock);
+        ctx->base = base;
+        base += ctx->config.size;
     }
 
-    if(!device_is_ready(m24m02d_i2c.bus)) {
+    return 0;
+}
+
+/*
+ * @brief m24m02 write byte, linear address
+ *        the address selects the chip, then the block (device select code), then the byte. 
+ *        goes through the RAM page cache when CONFIG_M24M02_CACHE_PAGES > 0. 
+ *
+ * @param addr A17-A0 address, 0x00000-0x3FFFF
+ * @param buf data buffer
+ * @param length data length
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_write(uint32_t addr, uint8_t *buf, size_t length) {
+    if (addr > M24M02_SIZE || length > M24M02_SIZE - addr) {
+        LOG_ERR("no enough space!");
+        LOG_ERR("write failed!");
         return -1;
     }
 
-    if(!device_is_ready(m24m02e_i2c.bus)) {
+#if CONFIG_M24M02_CACHE_PAGES > 0
+    return m24m02_cache_write(addr, buf, length);
+#else
+    return m24m02_bus_write(addr, buf, length);
+#endif
+}
+
+/*
+ * @brief m24m02 read byte, linear address
+ *        goes through the RAM page cache when CONFIG_M24M02_CACHE_PAGES > 0. 
+ *
+ * @param addr A17-A0 address, 0x00000-0x3FFFF
+ * @param buf where data will be written to
+ * @param length data length
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_read(uint32_t addr, uint8_t *buf, size_t length) {
+    if (addr > M24M02_SIZE || length > M24M02_SIZE - addr) {
+        LOG_ERR("read address check failed!");
+        LOG_ERR("read failed!");
         return -1;
     }
 
-    return 0;
+#if CONFIG_M24M02_CACHE_PAGES > 0
+    return m24m02_cache_read(addr, buf, length);
+#else
+    return m24m02_bus_read(addr, buf, length);
+#endif
 }
 
 /*
- * @brief m24m02 write byte
+ * @brief m24m02 differential write, linear address
+ *        each target page is read and compared first, pages that already match are 
+ *        skipped, other pages are programmed from the first to the last changed byte only. 
+ *        saves write cycles and endurance when re-uploading mostly unchanged assets. 
+ *        compare reads go to the bus (patched with dirty cached pages) and allocate 
+ *        no cache line, so a re-upload does not evict the hot pages. 
+ *        the compare buffer is shared, concurrent differential writes run one by one, 
+ *        m24m02_diff_lock is taken before the page cache and the bus lock. 
  *
- * @param sector a = 0, b = 1, c = 2 and d = 3
- * @param addr_high A15-A8 address
- * @param addr_low A7-A0 address
+ * @param addr A17-A0 address, 0x00000-0x3FFFF
  * @param buf data buffer
  * @param length data length
  * 
  * @retval 0 succeed
  * @retval -1 failed
  */
-int m24m02x_write(uint8_t sector, uint8_t addr_high, uint8_t addr_low, 
-        uint8_t *buf, size_t length) {
-
-    LOG_DBG("[sector %d] remains %d byte, and need %d byte...", 
-            sector, (256 - addr_high - 1) * 256 + (256 - addr_low), length);
+int m24m02_write_diff(uint32_t addr, uint8_t *buf, size_t length) {
+    int ret = 0;
 
-    // check if there is enough space
-    if (((256 - addr_high - 1) * 256 + (256 - addr_low)) >= length) {                               // enough
+    if (addr > M24M02_SIZE || length > M24M02_SIZE - addr) {
+        LOG_ERR("no enough space!");
+        LOG_ERR("write failed!");
+        return -1;
+    }
 
-        LOG_DBG("enough space...");
+    k_mutex_lock(&m24m02_diff_lock, K_FOREVER);
 
-        uint8_t curr_addr_high = addr_high;
-        uint8_t curr_addr_low = addr_low;
-        size_t shift = 0;
+    while (length > 0) {
+        size_t chunk = MIN(length, M24M02_PAGE_SIZE - (addr % M24M02_PAGE_SIZE));                   // never cross a page
+        size_t first = 0;
+        size_t last = chunk;
 
-        if (length <= (256 - curr_addr_low)) {                                                      // 1 page
+        if (m24m02_cache_peek(addr, m24m02_diff_buf, chunk)) {                                      // do not evict hot pages
+            ret = -1;
+            break;
+        }
 
-            LOG_DBG("need 1 page...");
-            LOG_DBG("start to write page 1...");
+        while (first < chunk && m24m02_diff_buf[first] == buf[first]) {
+            first++;
+        }
 
-            memcpy(m24m02_tx_buf, buf, length);
-            if (m24m02_send(sector, curr_addr_high, curr_addr_low, length)) {
-                return -1;
+        if (first == chunk) {                                                                       // page matches
+            m24m02_diff_stats.pages_skipped++;
+        } else {
+            while (m24m02_diff_buf[last - 1] == buf[last - 1]) {
+                last--;
             }
 
-            LOG_DBG("write from 0x%.02x 0x%.02x to 0x%.02x 0x%.02x, %d byte...", 
-                    curr_addr_high, curr_addr_low, curr_addr_high, 
-                    curr_addr_low + length - 1, length);
-            LOG_DBG("page 1 done...");
-            LOG_DBG("remain 0 byte...");
-            LOG_DBG("write secceed.");
-            printk("\r\n");
-
-            return 0;
-
-        } else {                                                                                    // > 1 page
+            if (m24m02_write(addr + first, buf + first, last - first)) {
+                ret = -1;
+                break;
+            }
 
-            LOG_DBG("need more than 1 page.");
-            LOG_DBG("start to write page 1...");
+            m24m02_diff_stats.pages_programmed++;
+            m24m02_diff_stats.bytes_programmed += last - first;
+        }
 
-            memcpy(m24m02_tx_buf, buf, 256 - curr_addr_low);
-            if (m24m02_send(sector, curr_addr_high, curr_addr_low, 256 - curr_addr_low)) {
-                return -1;
-            }
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
 
-            shift = 256 - curr_addr_low;
+    k_mutex_unlock(&m24m02_diff_lock);
 
-            LOG_DBG("write from 0x%.02x 0x%.02x to 0x%.02x 0xFF, %d byte...", 
-                    curr_addr_high, curr_addr_low, curr_addr_high, shift);
-            LOG_DBG("page 1 done...");
-            LOG_DBG("remain %d byte...", length - shift);
-            LOG_DBG("buf pointer moves from %p to %p...", (void *)buf, (void *)(buf + shift - 1));
-            LOG_DBG("shift is %d...", shift);
-            printk("\r\n");
+    return ret;
+}
 
-            curr_addr_high += 1;                                                                    // will not bound
-            curr_addr_low = 0x00;
+/*
+ * @brief get differential write statistics
+ *
+ * @param stats where statistics will be copied to
+ */
+void m24m02_diff_stats_get(struct m24m02_diff_stats_st *stats) {
+    k_mutex_lock(&m24m02_diff_lock, K_FOREVER);
+    *stats = m24m02_diff_stats;
+    k_mutex_unlock(&m24m02_diff_lock);
+}
 
-            uint8_t i;
+/*
+ * @brief m24m02 fill (erase) with a repeated byte, linear address
+ *        every page is programmed from one page buffer holding the pattern, 
+ *        one transaction and one ACK polled write cycle per page, 
+ *        so a full 256K wipe costs 1024 write cycles and 256 byte of RAM. 
+ *        the page cache is flushed before and invalidated after. 
+ *        the time taken is kept in m24m02_fill_stats. 
+ *
+ * @param addr A17-A0 address, 0x00000-0x3FFFF
+ * @param length data length
+ * @param pattern byte to fill with, 0xFF to erase
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_fill(uint32_t addr, size_t length, uint8_t pattern) {
+    uint32_t start;
+    uint32_t pages = 0;
+    size_t done = 0;
+    int ret = 0;
 
-            for (i = 0; i < ((length - (256 - addr_low)) / 256); i++) {
+    if (addr > M24M02_SIZE || length > M24M02_SIZE - addr) {
+        LOG_ERR("no enough space!");
+        LOG_ERR("fill failed!");
+        return -1;
+    }
 
-                LOG_DBG("start to write page %d...", i + 2);
+    k_mutex_lock(&m24m02_fill_lock, K_FOREVER);
 
-                memcpy(m24m02_tx_buf, buf + shift, 256);
-                if (m24m02_send(sector, curr_addr_high, curr_addr_low, 256)) {
-                    return -1;
-                }
+    memset(m24m02_fill_buf, pattern, sizeof(m24m02_fill_buf));
 
-                shift += 256;
+    if (m24m02_cache_flush()) {
+        k_mutex_unlock(&m24m02_fill_lock);
+        return -1;
+    }
 
-                LOG_DBG("write from 0x%.02x 0x00 to 0x%.02x 0xFF, 256 byte...", 
-                        curr_addr_high, curr_addr_high);
-                LOG_DBG("page %d done...", i + 2);
-                LOG_DBG("remain %d byte...", length - shift);
+    start = k_cycle_get_32();
 
-                if (length - shift == 0) {                                                          // no data left
-                    LOG_DBG("write secceed.");
-                    printk("\r\n");
-                    return 0;
-                } else {
-                    curr_addr_high += 1;                                                            // will not bound
+    while (done < length) {
+        size_t chunk = MIN(length - done, M24M02_PAGE_SIZE - ((addr + done) % M24M02_PAGE_SIZE));
 
-                    LOG_DBG("buf pointer moves from %p to %p...", 
-                            (void *)(buf + shift - 256), (void *)(buf + shift - 1));
-                    LOG_DBG("shift is %d...", shift);
-                    printk("\r\n");
-                }
-            }
+        if (m24m02_bus_write(addr + done, m24m02_fill_buf, chunk)) {                                // split again for smaller pages
+            ret = -1;
+            break;
+        }
 
-            if (i == 0) {                                                                           // not enter the loop
-                i = 2;
-            } else {
-                i = (length - (256 - addr_low)) / 256 + 2;
-            }
+        pages++;
+        done += chunk;
+    }
 
-            LOG_DBG("start to write page %d...", i);
+    m24m02_fill_stats.elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    m24m02_fill_stats.bytes = done;
+    m24m02_fill_stats.pages = pages;
+    m24m02_fill_stats.bytes_per_s = m24m02_fill_stats.elapsed_us ? 
+            (uint64_t)done * USEC_PER_SEC / m24m02_fill_stats.elapsed_us : 0;
 
-            memcpy(m24m02_tx_buf, buf + shift, length - shift);
-            if (m24m02_send(sector, curr_addr_high, curr_addr_low, length - shift)) {
-                return -1;
-            }
+    m24m02_cache_invalidate();                                                                      // cached pages are stale
 
-            LOG_DBG("write from 0x%.02x 0x00 to 0x%.02x 0x%.02x, %d byte...", 
-                    curr_addr_high, curr_addr_high, length - shift - 1, length - shift);
-            LOG_DBG("page %d done...", i);
-            LOG_DBG("remain 0 byte...");
-            LOG_DBG("write secceed.");
-            printk("\r\n");
+    LOG_DBG("fill 0x%.05x, %d byte, %u us, %u byte/s...", addr, done, 
+            m24m02_fill_stats.elapsed_us, m24m02_fill_stats.bytes_per_s);
 
-            return 0;
-        }
-    } else {                                                                                        // not enough
+    k_mutex_unlock(&m24m02_fill_lock);
 
-        LOG_ERR("no enough space!");
-        LOG_ERR("write failed!");
-        printk("\r\n");
-        return -1;
+    return ret;
+}
 
-    }
+/*
+ * @brief get the size and throughput of the last fill
+ *
+ * @param stats where statistics will be copied to
+ */
+void m24m02_fill_stats_get(struct m24m02_fill_stats_st *stats) {
+    k_mutex_lock(&m24m02_fill_lock, K_FOREVER);
+    *stats = m24m02_fill_stats;
+    k_mutex_unlock(&m24m02_fill_lock);
 }
 
 /*
- * @brief m24m02 identification page write byte
+ * @brief m24m02 write byte on the bus, bypass the page cache
+ *        data is split at page boundaries, the bus lock is released between pages. 
  *
- * @param addr A7-A0 address
+ * @param addr A17-A0 address, already checked by caller
  * @param buf data buffer
  * @param length data length
  * 
  * @retval 0 succeed
  * @retval -1 failed
  */
-int m24m02e_write(uint8_t addr, uint8_t *buf, size_t length) {
-    LOG_DBG("[sector e] remains %d byte, and need %d byte...", 256 - addr, length);
-
-    if (length <= 256 - addr) {                                                                     // enough space
+int m24m02_bus_write(uint32_t addr, uint8_t *buf, size_t length) {
+    LOG_DBG("write 0x%.05x, %d byte...", addr, length);
 
-        LOG_DBG("enough space...");
-        LOG_DBG("start to write [sector e]...");
+    while (length > 0) {
+        struct m24m02_ctx_st *ctx = m24m02_ctx_get(addr);
 
-        memcpy(m24m02_tx_buf, buf, length);
-        if (m24m02_send(4, 0x00, addr, length)) {
+        if (ctx == NULL) {
             return -1;
         }
 
-        LOG_DBG("write from 0x%.02x to 0x%.02x, %d byte...", addr, addr + length - 1, length);
-        LOG_DBG("[sector e] done...");
-        LOG_DBG("write secceed.");
-        printk("\r\n");
+        uint32_t offset = addr - ctx->base;
+        uint16_t page_size = ctx->config.page_size;
+        size_t chunk = MIN(length, page_size - (offset % page_size));                               // never cross a page
 
-        return 0;
+        if (m24m02_send(ctx, offset / ctx->config.block_size, offset % ctx->config.block_size, 
+                buf, chunk)) {
+            LOG_ERR("write 0x%.05x failed!", addr);
+            return -1;
+        }
 
-    } else {
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
 
-        LOG_ERR("no enough space!");
-        LOG_ERR("write failed!");
-        printk("\r\n");
-        return -1;
+    LOG_DBG("write secceed.");
 
-    }
+    return 0;
 }
 
-static int m24m02_send(uint8_t sector, uint8_t addr_high, uint8_t addr_low, size_t length) {
+/*
+ * @brief m24m02 read byte on the bus, bypass the page cache
+ *        on parts whose internal address counter covers the whole chip (m24m02), 
+ *        one sequential read continues across block boundaries with a single address phase. 
+ *        long reads are split in bursts of M24M02_READ_BURST_MS at the bus speed to stay 
+ *        within the i2c driver transfer timeout, the bus lock is released between bursts. 
+ *
+ * @param addr A17-A0 address, already checked by caller
+ * @param buf where data will be written to
+ * @param length data length
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_bus_read(uint32_t addr, uint8_t *buf, size_t length) {
+    LOG_DBG("read 0x%.05x, %d byte...", addr, length);
+
+    while (length > 0) {
+        struct m24m02_ctx_st *ctx = m24m02_ctx_get(addr);
 
-    if (length + 2 > 255) {                                                                         // should send twice
-        if (m24m02_send_twice(sector, addr_high, addr_low, length)) {
+        if (ctx == NULL) {
             return -1;
         }
-    } else {                                                                                        // send once
-        if (m24m02_send_once(sector, addr_high, addr_low, length)) {
-            return -1;
-        }
-    }
-    
-    return 0;
-}
 
-static int m24m02_send_twice(uint8_t sector, uint8_t addr_high, uint8_t addr_low, size_t length) {
-    m24m02_tx_buf_part1[0] = addr_high;
-    m24m02_tx_buf_part1[1] = addr_low;
-    memcpy(m24m02_tx_buf_part1 + 2, m24m02_tx_buf, 253);
+        uint32_t offset = addr - ctx->base;
+        uint32_t block_size = ctx->config.block_size;
+        size_t chunk = MIN(length, m24m02_read_burst_size());
 
-    m24m02_tx_buf_part2[0] = addr_high;
-    m24m02_tx_buf_part2[1] = addr_low + 253;
-    memcpy(m24m02_tx_buf_part2 + 2, m24m02_tx_buf + 253, length - 253);
+        chunk = MIN(chunk, ctx->config.size - offset);                                              // stop at chip end
+        if (!ctx->config.read_across_blocks) {
+            chunk = MIN(chunk, block_size - (offset % block_size));                                 // stop at block boundary
+        }
 
-    switch (sector) {
-        case 0:
-            if(i2c_write_dt(&m24m02a_i2c, m24m02_tx_buf_part1, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            if(i2c_write_dt(&m24m02a_i2c, m24m02_tx_buf_part2, length - 253 + 2)) {
-                return -1;
-            }
-            break;
-        case 1:
-            if(i2c_write_dt(&m24m02b_i2c, m24m02_tx_buf_part1, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            if(i2c_write_dt(&m24m02b_i2c, m24m02_tx_buf_part2, length - 253 + 2)) {
-                return -1;
-            }
-            break;
-        case 2:
-            if(i2c_write_dt(&m24m02c_i2c, m24m02_tx_buf_part1, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            if(i2c_write_dt(&m24m02c_i2c, m24m02_tx_buf_part2, length - 253 + 2)) {
-                return -1;
-            }
-            break;
-        case 3:
-            if(i2c_write_dt(&m24m02d_i2c, m24m02_tx_buf_part1, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            if(i2c_write_dt(&m24m02d_i2c, m24m02_tx_buf_part2, length - 253 + 2)) {
-                return -1;
-            }
-            break;
-        case 4:
-            if(i2c_write_dt(&m24m02e_i2c, m24m02_tx_buf_part1, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            if(i2c_write_dt(&m24m02e_i2c, m24m02_tx_buf_part2, length - 253 + 2)) {
-                return -1;
-            }
-            break;
-        default:
+        if (m24m02_receive(ctx, offset / block_size, offset % block_size, buf, chunk)) {
+            LOG_ERR("read 0x%.05x failed!", addr);
             return -1;
+        }
+
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
     }
 
-    k_msleep(DELAY_MS);
+    LOG_DBG("read secceed.");
 
     return 0;
 }
 
-static int m24m02_send_once(uint8_t sector, uint8_t addr_high, uint8_t addr_low, size_t length) {
-    m24m02_tx_buf_part1[0] = addr_high;
-    m24m02_tx_buf_part1[1] = addr_low;
-    memcpy(m24m02_tx_buf_part1 + 2, m24m02_tx_buf, length);
+/*
+ * @brief m24m02 write byte
+ *
+ * @param sector a = 0, b = 1, c = 2 and d = 3
+ * @param addr_high A15-A8 address
+ * @param addr_low A7-A0 address
+ * @param buf data buffer
+ * @param length data length
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02x_write(uint8_t sector, uint8_t addr_high, uint8_t addr_low, 
+        uint8_t *buf, size_t length) {
+    const struct m24m02_config_st *config = &m24m02_ctxs[0].config;
+    uint16_t offset = (addr_high << 8) | addr_low;
 
-    switch (sector) {
-        case 0:
-            if(i2c_write_dt(&m24m02a_i2c, m24m02_tx_buf_part1, length + 2)) {
-                return -1;
-            }
-            break;
-        case 1:
-            if(i2c_write_dt(&m24m02b_i2c, m24m02_tx_buf_part1, length + 2)) {
-                return -1;
-            }
-            break;
-        case 2:
-            if(i2c_write_dt(&m24m02c_i2c, m24m02_tx_buf_part1, length + 2)) {
-                return -1;
-            }
-            break;
-        case 3:
-            if(i2c_write_dt(&m24m02d_i2c, m24m02_tx_buf_part1, length + 2)) {
-                return -1;
-            }
-            break;
-        case 4:
-            if(i2c_write_dt(&m24m02e_i2c, m24m02_tx_buf_part1, length + 2)) {
-                return -1;
-            }
-            break;
-        default:
-            return -1;
+    if (sector >= config->block_count || length > config->block_size - offset) {                    // stay in sector
+        LOG_ERR("no enough space!");
+        LOG_ERR("write failed!");
+        return -1;
     }
-    
-    k_msleep(DELAY_MS);
 
-    return 0;
+    return m24m02_write(sector * config->block_size + offset, buf, length);
 }
 
+/*
+ * @brief m24m02 identification page write byte
+ *
+ * @param addr A7-A0 address
+ * @param buf data buffer
+ * @param length data length
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02e_write(uint8_t addr, uint8_t *buf, size_t length) {
+    if (length > m24m02_ctxs[0].config.page_size - addr) {
+        LOG_ERR("no enough space!");
+        LOG_ERR("write failed!");
+        return -1;
+    }
+
+    if (m24m02_send(&m24m02_ctxs[0], M24M02_ID_PAGE_SECTOR, addr, buf, length)) {
+        return -1;
+    }
+
+    LOG_DBG("write [sector e] from 0x%.02x, %d byte...", addr, length);
 
+    return 0;
+}
 
 /*
  * @brief m24m02 read byte
@@ -372,282 +428,330 @@ static int m24m02_send_once(uint8_t sector, uint8_t addr_high, uint8_t addr_low,
  */
 int m24m02x_read(uint8_t sector, uint8_t addr_high, uint8_t addr_low, 
         uint8_t *buf, size_t length) {
+    const struct m24m02_config_st *config = &m24m02_ctxs[0].config;
+    uint16_t offset = (addr_high << 8) | addr_low;
 
-    if (((256 - addr_high - 1) * 256 + (256 - addr_low)) >= length) {
-        LOG_DBG("read address checked...");
-        
-        uint8_t curr_addr_high = addr_high;
-        uint8_t curr_addr_low = addr_low;
-        size_t shift = 0;
-
-        if (length <= (256 - curr_addr_low)) {
-            LOG_DBG("have 1 page...");
-            LOG_DBG("start to read page 1...");
-
-            m24m02_rx_addr[0] = curr_addr_high;
-            m24m02_rx_addr[1] = curr_addr_low;
-            if (m24m02_receive(sector, buf, length)) {
-                return -1;
-            }
+    if (sector >= config->block_count || length > config->block_size - offset) {                    // stay in sector
+        LOG_ERR("read address check failed!");
+        LOG_ERR("read failed!");
+        return -1;
+    }
 
-            LOG_DBG("read from 0x%.02x 0x%.02x to 0x%.02x 0x%.02x, %d byte...", 
-                    curr_addr_high, curr_addr_low, curr_addr_high, 
-                    curr_addr_low + length - 1, length);
-            LOG_DBG("page 1 done...");
-            LOG_DBG("remain 0 byte...");
-            LOG_DBG("read secceed.");
-            printk("\r\n");
+    return m24m02_read(sector * config->block_size + offset, buf, length);
+}
 
-            return 0;
+/*
+ * @brief m24m02 identification page read byte
+ *
+ * @param addr A7-A0 address
+ * @param buf where data will be written to
+ * @param length data length
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02e_read(uint8_t addr, uint8_t *buf, size_t length) {
+    if (length > m24m02_ctxs[0].config.page_size - addr) {
+        LOG_ERR("read address check failed!");
+        LOG_ERR("read failed!");
+        return -1;
+    }
 
-        } else {
-            LOG_DBG("have more than 1 page...");
-            LOG_DBG("start to read page 1...");
+    if (m24m02_receive(&m24m02_ctxs[0], M24M02_ID_PAGE_SECTOR, addr, buf, length)) {
+        return -1;
+    }
 
-            m24m02_rx_addr[0] = curr_addr_high;
-            m24m02_rx_addr[1] = curr_addr_low;
-            if (m24m02_receive(sector, buf, 256 - curr_addr_low)) {
-                return -1;
-            }
+    LOG_DBG("read [sector e] from 0x%.02x, %d byte...", addr, length);
 
-            shift = 256 - curr_addr_low;
+    return 0;
+}
 
-            LOG_DBG("read from 0x%.02x 0x%.02x to 0x%.02x 0xFF, %d byte...", 
-                    curr_addr_high, curr_addr_low, curr_addr_high, shift);
-            LOG_DBG("page 1 done...");
-            LOG_DBG("remain %d byte...", length - shift);
-            LOG_DBG("buf pointer moves from %p to %p...", (void *)buf, (void *)(buf + shift - 1));
-            LOG_DBG("shift is %d...", shift);
-            printk("\r\n");
+/*
+ * @brief set the i2c speed of m24m02 transfers, from the next page or read burst on
+ *        the bus runs at this speed only while m24m02 holds it. 
+ *
+ * @param speed I2C_SPEED_STANDARD, I2C_SPEED_FAST or I2C_SPEED_FAST_PLUS
+ *
+ * @retval speed set before
+ */
+uint32_t m24m02_bus_speed_set(uint32_t speed) {
+    uint32_t prev = m24m02_bus_speed;
 
-            curr_addr_high += 1;                                                                    // will not bound
-            curr_addr_low = 0x00;
+    m24m02_bus_speed = speed;
 
-            uint8_t i;
+    return prev;
+}
 
-            for (i = 0; i < ((length - (256 - addr_low)) / 256); i++) {
+/*
+ * @brief get the i2c speed m24m02 transfers really run at
+ *        lower than requested if the controller does not support it. 
+ *
+ * @retval I2C_SPEED_xx, 0 before the first transfer
+ */
+uint32_t m24m02_bus_speed_get(void) {
+    return i2c_bus_speed_get(m24m02_ctxs[0].config.bus);
+}
 
-                LOG_DBG("start to read page %d...", i + 2);
+/*
+ * @brief read burst size for the bus speed, 2K at 100 kHz, 8K at 400 kHz
+ *        fast mode plus is counted as 400 kHz, it falls back when not supported. 
+ *
+ * @retval byte, a multiple of M24M02_PAGE_SIZE
+ */
+static size_t m24m02_read_burst_size(void) {
+    uint32_t rate = m24m02_bus_speed == I2C_SPEED_STANDARD ? I2C_BITRATE_STANDARD : I2C_BITRATE_FAST;
+    size_t size = rate / 9 * M24M02_READ_BURST_MS / MSEC_PER_SEC;                                   // 9 bit per byte
 
-                m24m02_rx_addr[0] = curr_addr_high;
-                m24m02_rx_addr[1] = curr_addr_low;
-                if (m24m02_receive(sector, buf + shift, 256)) {
-                    return -1;
-                }
+    return MIN(ROUND_DOWN(size, M24M02_PAGE_SIZE), M24M02_READ_BURST_MAX);
+}
 
-                shift += 256;
+/*
+ * @brief find the chip holding a linear address
+ *
+ * @param addr linear address
+ *
+ * @retval chip context, NULL if addr is out of range
+ */
+static struct m24m02_ctx_st *m24m02_ctx_get(uint32_t addr) {
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_ctxs); i++) {
+        if (addr - m24m02_ctxs[i].base < m24m02_ctxs[i].config.size) {
+            return &m24m02_ctxs[i];
+        }
+    }
 
-                LOG_DBG("read from 0x%.02x 0x00 to 0x%.02x 0xFF, 256 byte...", 
-                        curr_addr_high, curr_addr_high);
-                LOG_DBG("page %d done...", i + 2);
-                LOG_DBG("remain %d byte...", length - shift);
+    return NULL;
+}
 
-                if (length - shift == 0) {                                                          // no data left
-                    LOG_DBG("read secceed.");
-                    printk("\r\n");
-                    return 0;
-                } else {
-                    curr_addr_high += 1;                                                            // will not bound
+/*
+ * @brief get the device select code of a sector
+ *
+ * @param ctx chip context
+ * @param sector block number, or M24M02_ID_PAGE_SECTOR
+ * @param dev_addr where the device select code will be written to
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, sector is invalid
+ */
+static int m24m02_select(const struct m24m02_ctx_st *ctx, uint8_t sector, uint16_t *dev_addr) {
+    if (sector == M24M02_ID_PAGE_SECTOR) {
+        *dev_addr = ctx->config.id_addr;
+        return ctx->config.id_addr ? 0 : -1;
+    }
 
-                    LOG_DBG("buf pointer moves from %p to %p...", 
-                            (void *)(buf + shift - 256), (void *)(buf + shift - 1));
-                    LOG_DBG("shift is %d...", shift);
-                    printk("\r\n");
-                }
-            }
+    *dev_addr = ctx->config.addr + sector * ctx->config.addr_step;
 
-            if (i == 0) {                                                                           // not enter the loop
-                i = 2;
-            } else {
-                i = (length - (256 - addr_low)) / 256 + 2;
-            }
+    return sector < ctx->config.block_count ? 0 : -1;
+}
 
-            LOG_DBG("start to read page %d...", i);
+/*
+ * @brief send up to 1 page in a single i2c transaction
+ *        address bytes and data are chained as two write messages, 
+ *        the second message continues the first one without RESTART or STOP, 
+ *        so the whole page costs one write cycle. 
+ *        the data message points straight into the caller buffer, nothing is copied. 
+ *        the bus lock and the i2c bus are held until the write cycle ends. 
+ *
+ * @param ctx chip context
+ * @param sector block number, or M24M02_ID_PAGE_SECTOR
+ * @param addr A15-A0 address in the sector
+ * @param buf data buffer
+ * @param length data length, max 1 page
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int m24m02_send(struct m24m02_ctx_st *ctx, uint8_t sector, uint16_t addr, 
+        uint8_t *buf, size_t length) {
+    uint16_t dev_addr;
+    int ret = -1;
 
-            m24m02_rx_addr[0] = curr_addr_high;
-            m24m02_rx_addr[1] = curr_addr_low;
-            if (m24m02_receive(sector, buf + shift, length - shift)) {
-                return -1;
-            }
+    if (m24m02_select(ctx, sector, &dev_addr) || length > ctx->config.page_size) {
+        return -1;
+    }
 
-            LOG_DBG("read from 0x%.02x 0x00 to 0x%.02x 0x%.02x, %d byte...", 
-                    curr_addr_high, curr_addr_high, length - shift - 1, length - shift);
-            LOG_DBG("page %d done...", i);
-            LOG_DBG("remain 0 byte...");
-            LOG_DBG("read secceed.");
-            printk("\r\n");
+    k_mutex_lock(&ctx->lock, K_FOREVER);
 
-            return 0;
-        }
-    } else {
-        LOG_ERR("read address check failed!");
-        LOG_ERR("read failed!");
-        printk("\r\n");
+    if (i2c_bus_acquire(ctx->config.bus, m24m02_bus_speed)) {
+        k_mutex_unlock(&ctx->lock);
         return -1;
     }
+
+    ctx->tx_addr[0] = addr >> 8;
+    ctx->tx_addr[1] = addr & 0xFF;
+
+    struct i2c_msg msgs[2] = {
+        {
+            .buf = ctx->tx_addr, 
+            .len = sizeof(ctx->tx_addr), 
+            .flags = I2C_MSG_WRITE, 
+        },
+        {
+            .buf = buf, 
+            .len = length, 
+            .flags = I2C_MSG_WRITE | I2C_MSG_STOP,                                                  // no RESTART, continue
+        },
+    };
+
+    ctx->addr_counter_valid = false;
+
+    if (i2c_transfer(ctx->config.bus, msgs, ARRAY_SIZE(msgs), dev_addr) 
+            || m24m02_wait_ready(ctx, dev_addr)) {
+        goto unlock;
+    }
+
+    if (sector != M24M02_ID_PAGE_SECTOR) {                                                          // ACK polling dummy write set it
+        ctx->addr_counter = sector * ctx->config.block_size + addr;
+        ctx->addr_counter_valid = true;
+#if defined(CONFIG_M24M02_WEAR_STATS)
+        m24m02_wear_count(ctx->base + ctx->addr_counter);
+#endif
+    }
+
+    ret = 0;
+
+unlock:
+    i2c_bus_release(ctx->config.bus);
+    k_mutex_unlock(&ctx->lock);
+
+    return ret;
 }
 
 /*
- * @brief m24m02 identification page read byte
+ * @brief wait until the internal write cycle ends (ACK polling)
+ *        m24m02 does not acknowledge its device select code while programming, 
+ *        so the address bytes in ctx->tx_addr are re-sent (dummy write, 
+ *        no data byte, no write cycle) until the device acknowledges. 
+ *        the observed write cycle time is recorded in ctx->twr_stats, caller holds the bus lock. 
+ *
+ * @param ctx chip context
+ * @param dev_addr device select code of the sector just written
  *
- * @param addr A7-A0 address
- * @param buf where data will be written to
- * @param length data length
- * 
  * @retval 0 succeed
- * @retval -1 failed
+ * @retval -1 failed, write cycle did not end in M24M02_WRITE_TIMEOUT_MS
  */
-int m24m02e_read(uint8_t addr, uint8_t *buf, size_t length) {
-    if ((256 - addr) >= length) {
-        LOG_DBG("read address checked...");
-        LOG_DBG("start to read [sector e]...");
+static int m24m02_wait_ready(struct m24m02_ctx_st *ctx, uint16_t dev_addr) {
+    struct m24m02_twr_stats_st *stats = &ctx->twr_stats;
+    uint32_t start = k_cycle_get_32();
+    uint32_t elapsed_us;
 
-        m24m02_rx_addr[0] = 0x00;
-        m24m02_rx_addr[1] = addr;
-        if (m24m02_receive(4, buf, length)) {
-            return -1;
+    while (1) {
+        if (!i2c_write(ctx->config.bus, ctx->tx_addr, sizeof(ctx->tx_addr), dev_addr)) {            // ACK, write cycle ends
+            break;
         }
 
-        LOG_DBG("read from 0x%.02x to 0x%.02x, %d byte...", addr, addr + length - 1, length);
-        LOG_DBG("[sector e] done...");
-        LOG_DBG("read secceed.");
-        printk("\r\n");
+        elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        if (elapsed_us > M24M02_WRITE_TIMEOUT_MS * USEC_PER_MSEC) {
+            stats->timeouts++;
+            LOG_ERR("write cycle timeout!");
+            return -1;
+        }
 
-        return 0;
-    } else {
+        k_usleep(M24M02_ACK_POLL_INTERVAL_US);
+    }
 
-        LOG_ERR("read address check failed!");
-        LOG_ERR("read failed!");
-        printk("\r\n");
-        return -1;
+    elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
 
+    if (stats->count == 0 || elapsed_us < stats->min_us) {
+        stats->min_us = elapsed_us;
+    }
+    if (elapsed_us > stats->max_us) {
+        stats->max_us = elapsed_us;
     }
+    stats->last_us = elapsed_us;
+    stats->total_us += elapsed_us;
+    stats->count++;
+
+    LOG_DBG("write cycle %u us...", elapsed_us);
+
+    return 0;
 }
 
-static int m24m02_receive(uint8_t sector, uint8_t *buf, size_t length) {
+/*
+ * @brief get the observed write cycle time (tWR) statistics of all chips
+ *
+ * @param stats where statistics will be copied to
+ */
+void m24m02_twr_stats_get(struct m24m02_twr_stats_st *stats) {
+    memset(stats, 0, sizeof(*stats));
 
-    if (length > 255) {                                                                             // length = 256, should reveive twice
-        if (m24m02_receive_twice(sector, buf)) {
-            return -1;
-        }
-    } else {                                                                                        // reveive once
-        if (m24m02_receive_once(sector, buf, length)) {
-            return -1;
+    for (size_t i = 0; i < ARRAY_SIZE(m24m02_ctxs); i++) {
+        struct m24m02_ctx_st *ctx = &m24m02_ctxs[i];
+
+        k_mutex_lock(&ctx->lock, K_FOREVER);
+
+        if (ctx->twr_stats.count > 0) {
+            if (stats->count == 0 || ctx->twr_stats.min_us < stats->min_us) {
+                stats->min_us = ctx->twr_stats.min_us;
+            }
+            stats->max_us = MAX(stats->max_us, ctx->twr_stats.max_us);
+            stats->last_us = ctx->twr_stats.last_us;
         }
+        stats->count += ctx->twr_stats.count;
+        stats->timeouts += ctx->twr_stats.timeouts;
+        stats->total_us += ctx->twr_stats.total_us;
+
+        k_mutex_unlock(&ctx->lock);
     }
-    
-    return 0;
 }
 
-static int m24m02_receive_twice(uint8_t sector, uint8_t *buf) {
+/*
+ * @brief sequential read
+ *        if the internal address counter already points at addr (the previous 
+ *        read ended there, or a write was just ACK polled there), a current address 
+ *        read is used and the 2 byte address phase is skipped, 
+ *        otherwise a random address read is used. 
+ *        the bus lock and the i2c bus are held for the read, so the counter cannot move in between. 
+ *
+ * @param ctx chip context
+ * @param sector block number, or M24M02_ID_PAGE_SECTOR
+ * @param addr A15-A0 address in the sector
+ * @param buf where data will be written to
+ * @param length data length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int m24m02_receive(struct m24m02_ctx_st *ctx, uint8_t sector, uint16_t addr, 
+        uint8_t *buf, size_t length) {
+    uint32_t chip_addr = sector * ctx->config.block_size + addr;
+    bool in_array = sector != M24M02_ID_PAGE_SECTOR;
+    uint16_t dev_addr;
+    int ret;
 
-    switch (sector) {
-        case 0:
-            if(i2c_write_read_dt(&m24m02a_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            m24m02_rx_addr[1] = 0xFF;
-            if(i2c_write_read_dt(&m24m02a_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf + 255, 1)) {
-                return -1;
-            }
-            break;
-        case 1:
-            if(i2c_write_read_dt(&m24m02b_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            m24m02_rx_addr[1] = 0xFF;
-            if(i2c_write_read_dt(&m24m02b_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf + 255, 1)) {
-                return -1;
-            }
-            break;
-        case 2:
-            if(i2c_write_read_dt(&m24m02c_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            m24m02_rx_addr[1] = 0xFF;
-            if(i2c_write_read_dt(&m24m02c_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf + 255, 1)) {
-                return -1;
-            }
-            break;
-        case 3:
-            if(i2c_write_read_dt(&m24m02d_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            m24m02_rx_addr[1] = 0xFF;
-            if(i2c_write_read_dt(&m24m02d_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf + 255, 1)) {
-                return -1;
-            }
-            break;
-        case 4:
-            if(i2c_write_read_dt(&m24m02e_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, 255)) {
-                return -1;
-            }
-            k_msleep(DELAY_MS);
-            m24m02_rx_addr[1] = 0xFF;
-            if(i2c_write_read_dt(&m24m02e_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf + 255, 1)) {
-                return -1;
-            }
-            break;
-        default:
-            return -1;
+    if (m24m02_select(ctx, sector, &dev_addr)) {
+        return -1;
     }
 
-    k_msleep(DELAY_MS);
-    
-    return 0;
-}
+    k_mutex_lock(&ctx->lock, K_FOREVER);
 
-static int m24m02_receive_once(uint8_t sector, uint8_t *buf, size_t length) {
-    switch (sector) {
-        case 0:
-            if(i2c_write_read_dt(&m24m02a_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, length)) {
-                return -1;
-            }
-            break;
-        case 1:
-            if(i2c_write_read_dt(&m24m02b_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, length)) {
-                return -1;
-            }
-            break;
-        case 2:
-            if(i2c_write_read_dt(&m24m02c_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, length)) {
-                return -1;
-            }
-            break;
-        case 3:
-            if(i2c_write_read_dt(&m24m02d_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, length)) {
-                return -1;
-            }
-            break;
-        case 4:
-            if(i2c_write_read_dt(&m24m02e_i2c, m24m02_rx_addr, 
-                    sizeof(m24m02_rx_addr), buf, length)) {
-                return -1;
-            }
-            break;
-        default:
-            return -1;
+    if (i2c_bus_acquire(ctx->config.bus, m24m02_bus_speed)) {
+        k_mutex_unlock(&ctx->lock);
+        return -1;
     }
 
-    k_msleep(DELAY_MS);
-    
-    return 0;
-}
+    if (in_array && ctx->addr_counter_valid && ctx->addr_counter == chip_addr) {
+        ret = i2c_read(ctx->config.bus, buf, length, dev_addr);                                     // current address read
+    } else {
+        ctx->rx_addr[0] = addr >> 8;
+        ctx->rx_addr[1] = addr & 0xFF;
+        ret = i2c_write_read(ctx->config.bus, dev_addr, ctx->rx_addr, sizeof(ctx->rx_addr), 
+                buf, length);                                                                       // random address read
+    }
+
+    if (ret || !in_array) {                                                                         // unknown counter
+        ctx->addr_counter_valid = false;
+    } else {
+        uint32_t next = chip_addr + length;
+
+        if (!ctx->config.read_across_blocks && next % ctx->config.block_size == 0) {
+            next -= ctx->config.block_size;                                                         // rolls over in block
+        }
+        ctx->addr_counter = next % ctx->config.size;                                                // rolls over
+        ctx->addr_counter_valid = true;
+    }
+
+    i2c_bus_release(ctx->config.bus);
+    k_mutex_unlock(&ctx->lock);
+
+    return ret ? -1 : 0;
+}
\ No newline at end of file
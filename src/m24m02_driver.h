@@ -2,34 +2,99 @@
 #define _M24M02_DRIVER_H_
 
 #include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+
+#include "common.h"
 
 #define DEBUG_MODE 0                                                                                // 1: true
 #if DEBUG_MODE
 
-#define DELAY_MS 100
+#define M24M02_WRITE_TIMEOUT_MS 100
 
 #else
 
-#define DELAY_MS 8
+#define M24M02_WRITE_TIMEOUT_MS 10                                                                  // tWR max 10 ms
 
 #endif
 
+#define M24M02_ACK_POLL_INTERVAL_US 100
+
+#if defined(CONFIG_M24M02_BUS_SPEED_FAST_PLUS)
+#define M24M02_BUS_SPEED I2C_SPEED_FAST_PLUS                                                        // 1 MHz, falls back to 400 kHz
+#elif defined(CONFIG_M24M02_BUS_SPEED_FAST)
+#define M24M02_BUS_SPEED I2C_SPEED_FAST                                                             // 400 kHz
+#else
+#define M24M02_BUS_SPEED I2C_SPEED_STANDARD                                                         // 100 kHz
+#endif
+
+
+
+#define DT_DRV_COMPAT cubewatch_m24xx
 
+#define M24M02_PAGE_SIZE 256                                                                        // largest page, differential write unit
+#define M24M02_ID_PAGE_SECTOR 0xFF                                                                  // identification page, not a block
 
-#define M24M02_TX_BUF_SIZE_MAX 256
-#define M24M02_PART_BUF_SIZE_MAX 255                                                                // 256 - 1 byte Dev sel
+#define M24M02_READ_BURST_MAX 8192
+#define M24M02_READ_BURST_MS 200                                                                    // nrfx TWI transfer timeout is 500 ms
+#define M24M02_TX_ADDR_BUF_SIZE 2
 #define M24M02_RX_ADDR_BUF_SIZE 2
 
-static uint8_t m24m02_tx_buf[M24M02_TX_BUF_SIZE_MAX];
-static uint8_t m24m02_tx_buf_part1[M24M02_PART_BUF_SIZE_MAX];
-static uint8_t m24m02_tx_buf_part2[M24M02_PART_BUF_SIZE_MAX];
-static uint8_t m24m02_rx_addr[M24M02_RX_ADDR_BUF_SIZE];
-
-static int m24m02_send(uint8_t sector, uint8_t addr_high, uint8_t addr_low, size_t length);
-static int m24m02_send_twice(uint8_t sector, uint8_t addr_high, uint8_t addr_low, size_t length);
-static int m24m02_send_once(uint8_t sector, uint8_t addr_high, uint8_t addr_low, size_t length);
-static int m24m02_receive(uint8_t sector, uint8_t *buf, size_t length);
-static int m24m02_receive_twice(uint8_t sector, uint8_t *buf);
-static int m24m02_receive_once(uint8_t sector, uint8_t *buf, size_t length);
+/*
+ * @brief chip geometry, from devicetree (dts/bindings/cubewatch,m24xx.yaml)
+ *        block n of the array answers at device select code addr + n * addr_step, 
+ *        A15-A0 are sent as 2 address byte. 
+ */
+struct m24m02_config_st {
+    const struct device *bus;
+    uint16_t addr;                                                                                  // device select code of block 0
+    uint8_t addr_step;
+    uint16_t id_addr;                                                                               // identification page, 0: none
+    uint32_t size;
+    uint32_t block_size;                                                                            // one device select code
+    uint16_t page_size;
+    uint8_t block_count;
+    bool read_across_blocks;                                                                        // address counter rolls over blocks
+};
+
+/*
+ * @brief per chip driver state
+ *        lock is the bus lock, held for one page write (with its ACK polling) 
+ *        or one read burst, so threads sharing the chip interleave between pages 
+ *        and the address counter always matches the chip. 
+ */
+struct m24m02_ctx_st {
+    const struct m24m02_config_st config;
+    uint32_t base;                                                                                  // first linear address
+    struct k_mutex lock;
+    uint8_t tx_addr[M24M02_TX_ADDR_BUF_SIZE];
+    uint8_t rx_addr[M24M02_RX_ADDR_BUF_SIZE];
+    uint32_t addr_counter;                                                                          // internal address counter, in chip
+    bool addr_counter_valid;
+    struct m24m02_twr_stats_st twr_stats;                                                           // observed write cycle time
+};
+
+#define M24M02_CONFIG_CHECK(inst) \
+    BUILD_ASSERT(DT_INST_PROP(inst, pagesize) <= M24M02_PAGE_SIZE, "page larger than 256 byte"); \
+    BUILD_ASSERT(DT_INST_PROP(inst, size) / DT_INST_PROP(inst, block_count) <= 0x10000, \
+            "block larger than 2 address byte");
+
+DT_INST_FOREACH_STATUS_OKAY(M24M02_CONFIG_CHECK)
+
+static uint32_t m24m02_bus_speed = M24M02_BUS_SPEED;
+
+static uint8_t m24m02_diff_buf[M24M02_PAGE_SIZE];                                                   // differential write compare buffer
+static struct m24m02_diff_stats_st m24m02_diff_stats;
+
+static uint8_t m24m02_fill_buf[M24M02_PAGE_SIZE];                                                   // one page of the fill pattern
+static struct m24m02_fill_stats_st m24m02_fill_stats;
+
+static size_t m24m02_read_burst_size(void);
+static struct m24m02_ctx_st *m24m02_ctx_get(uint32_t addr);
+static int m24m02_select(const struct m24m02_ctx_st *ctx, uint8_t sector, uint16_t *dev_addr);
+static int m24m02_send(struct m24m02_ctx_st *ctx, uint8_t sector, uint16_t addr, 
+        uint8_t *buf, size_t length);
+static int m24m02_wait_ready(struct m24m02_ctx_st *ctx, uint16_t dev_addr);
+static int m24m02_receive(struct m24m02_ctx_st *ctx, uint8_t sector, uint16_t addr, 
+        uint8_t *buf, size_t length);
 
 #endif
\ No newline at end of file
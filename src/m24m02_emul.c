@@ -0,0 +1,286 @@
+/*
+ * @brief This file is an i2c emulator of m24m02 (and other "cubewatch,m24xx" parts) 
+ *        for native_sim, so the driver stack can be run and benchmarked without hardware. 
+ *        it answers at every block device select code (0x50-0x53) and 
+ *        at the identification page (0x58), and models 
+ *        - page wrap, data past the end of a page rolls over to its start 
+ *        - the internal address counter, current address reads and its roll over 
+ *        - NACK of the device select code during a write cycle of CONFIG_M24M02_EMUL_TWR_US 
+ *        - optionally a transfer length limit (255 byte, like nRF52832 TWIM EasyDMA) 
+ *        - bus time of each transfer at the configured i2c speed. 
+ */
+#include "m24m02_emul.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/drivers/emul.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_emul, LOG_LEVEL_ERR);
+
+static int64_t m24m02_emul_now_us(void) {
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+/*
+ * @brief spend the time the transfer takes on the bus
+ *        9 bit per byte (8 data, 1 ACK), device select byte per START / RESTART. 
+ */
+static void m24m02_emul_bus_time(const struct m24m02_emul_data_st *data, struct i2c_msg *msgs, 
+        int num_msgs) {
+#if defined(CONFIG_M24M02_EMUL_BUS_TIMING)
+    uint32_t config = 0;
+    uint32_t rate;
+    uint64_t bits = 9 + M24M02_EMUL_START_STOP_BITS;
+
+    i2c_get_config(data->bus, &config);
+
+    switch (I2C_SPEED_GET(config)) {
+        case I2C_SPEED_FAST:
+            rate = I2C_BITRATE_FAST;
+            break;
+        case I2C_SPEED_FAST_PLUS:
+            rate = I2C_BITRATE_FAST_PLUS;
+            break;
+        default:
+            rate = I2C_BITRATE_STANDARD;
+            break;
+    }
+
+    for (int i = 0; i < num_msgs; i++) {
+        bits += msgs[i].len * 9;
+        if (i > 0 && (msgs[i].flags & I2C_MSG_RESTART)) {
+            bits += 9 + 1;
+        }
+    }
+
+    k_busy_wait(bits * USEC_PER_SEC / rate);
+#endif
+}
+
+/*
+ * @brief write frame, consecutive write messages without RESTART
+ *        2 address byte, then data into the addressed page with page wrap. 
+ *        address only (ACK polling dummy write) moves the address counter, 
+ *        data starts a write cycle and leaves the counter after the last byte written. 
+ *        a frame over the length limit is rejected before anything changes. 
+ *
+ * @retval message count used
+ * @retval -EINVAL longer than CONFIG_M24M02_EMUL_XFER_MAX
+ */
+static int m24m02_emul_write(const struct m24m02_emul_cfg_st *cfg, struct m24m02_emul_data_st *data, 
+        uint8_t block, bool id, struct i2c_msg *msgs, int num_msgs) {
+    uint8_t addr_bytes[2];
+    uint32_t count = 0;                                                                             // byte in frame
+    uint32_t page_base = 0;
+    uint32_t offset = 0;
+    uint32_t pos = 0;
+    int used = 0;
+
+    do {                                                                                            // frame length first
+        count += msgs[used].len;
+        if (msgs[used++].flags & I2C_MSG_STOP) {
+            break;
+        }
+    } while (used < num_msgs && !(msgs[used].flags & (I2C_MSG_READ | I2C_MSG_RESTART)));
+
+    if (CONFIG_M24M02_EMUL_XFER_MAX && count > CONFIG_M24M02_EMUL_XFER_MAX) {
+        LOG_ERR("transfer of %u byte over the limit!", count);
+        return -EINVAL;
+    }
+
+    count = 0;
+    for (int m = 0; m < used; m++) {
+        for (uint32_t i = 0; i < msgs[m].len; i++, count++) {
+            if (count < sizeof(addr_bytes)) {
+                addr_bytes[count] = msgs[m].buf[i];
+                continue;
+            }
+
+            if (count == sizeof(addr_bytes)) {
+                uint16_t addr = (addr_bytes[0] << 8) | addr_bytes[1];
+
+                offset = addr % cfg->page_size;
+                page_base = id ? 0 : block * cfg->block_size + addr - offset;
+            }
+
+            pos = (offset + count - sizeof(addr_bytes)) % cfg->page_size;                           // page wrap
+            if (id) {
+                data->id_page[pos] = msgs[m].buf[i];
+            } else {
+                cfg->mem[page_base + pos] = msgs[m].buf[i];
+            }
+        }
+    }
+
+    if (count == sizeof(addr_bytes)) {                                                              // address only
+        uint16_t addr = (addr_bytes[0] << 8) | addr_bytes[1];
+
+        if (id) {
+            data->id_counter = addr % cfg->page_size;
+        } else {
+            data->counter = block * cfg->block_size + addr;
+        }
+    }
+
+    if (count > sizeof(addr_bytes)) {                                                               // data, write cycle
+        pos = (pos + 1) % cfg->page_size;                                                           // after the last byte, in page
+        if (id) {
+            data->id_counter = pos;
+        } else {
+            data->counter = page_base + pos;
+        }
+
+        data->busy_until_us = m24m02_emul_now_us() + CONFIG_M24M02_EMUL_TWR_US;
+        data->page_writes++;
+    }
+
+    return used;
+}
+
+/*
+ * @brief sequential read from the address counter
+ */
+static void m24m02_emul_read(const struct m24m02_emul_cfg_st *cfg, struct m24m02_emul_data_st *data, 
+        bool id, uint8_t *buf, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        if (id) {
+            buf[i] = data->id_page[data->id_counter];
+            data->id_counter = (data->id_counter + 1) % cfg->page_size;
+            continue;
+        }
+
+        buf[i] = cfg->mem[data->counter];
+
+        if (cfg->read_across_blocks) {
+            data->counter = (data->counter + 1) % cfg->size;
+        } else {
+            uint32_t block_base = data->counter - data->counter % cfg->block_size;
+
+            data->counter = block_base + (data->counter + 1) % cfg->block_size;                     // rolls over in block
+        }
+    }
+}
+
+/*
+ * @brief i2c emulator transfer, called by the i2c emul controller
+ *
+ * @param target emulator
+ * @param msgs messages
+ * @param num_msgs message count
+ * @param addr device select code
+ *
+ * @retval 0 succeed
+ * @retval -EIO NACK, write cycle in progress
+ * @retval -EINVAL transfer too long
+ */
+static int m24m02_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs, 
+        int addr) {
+    const struct m24m02_emul_cfg_st *cfg = target->cfg;
+    struct m24m02_emul_data_st *data = target->data;
+    bool id = cfg->id_addr && addr == cfg->id_addr;
+    uint8_t block = id ? 0 : (addr - cfg->addr) / cfg->addr_step;
+    int i = 0;
+
+    if (m24m02_emul_now_us() < data->busy_until_us) {                                               // device select not acknowledged
+        m24m02_emul_bus_time(data, msgs, 0);
+        data->nacks++;
+        return -EIO;
+    }
+
+    m24m02_emul_bus_time(data, msgs, num_msgs);
+
+    while (i < num_msgs) {
+        if (msgs[i].flags & I2C_MSG_READ) {
+            if (CONFIG_M24M02_EMUL_XFER_MAX && msgs[i].len > CONFIG_M24M02_EMUL_XFER_MAX) {
+                LOG_ERR("transfer of %u byte over the limit!", msgs[i].len);
+                return -EINVAL;
+            }
+
+            m24m02_emul_read(cfg, data, id, msgs[i].buf, msgs[i].len);
+            i++;
+        } else {
+            int used = m24m02_emul_write(cfg, data, block, id, &msgs[i], num_msgs - i);
+
+            if (used < 0) {
+                return used;
+            }
+            i += used;
+        }
+    }
+
+    return 0;
+}
+
+static const struct i2c_emul_api m24m02_emul_api = {
+    .transfer = m24m02_emul_transfer, 
+};
+
+/*
+ * @brief emulator init, register the other device select codes on the bus
+ *        block 0 is registered by the emulator framework. 
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int m24m02_emul_init(const struct emul *target, const struct device *parent) {
+    const struct m24m02_emul_cfg_st *cfg = target->cfg;
+    struct m24m02_emul_data_st *data = target->data;
+    uint8_t count = 0;
+
+    data->bus = parent;
+    memset(cfg->mem, 0xFF, cfg->size);                                                              // erased
+    memset(data->id_page, 0xFF, sizeof(data->id_page));
+
+    for (uint8_t i = 1; i <= cfg->block_count; i++) {
+        bool is_id = i == cfg->block_count;
+
+        if (is_id && cfg->id_addr == 0) {
+            break;
+        }
+
+        data->extra[count].target = target;
+        data->extra[count].api = &m24m02_emul_api;
+        data->extra[count].addr = is_id ? cfg->id_addr : cfg->addr + i * cfg->addr_step;
+
+        if (i2c_emul_register(parent, &data->extra[count])) {
+            return -1;
+        }
+        count++;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief the emulator framework needs a device on the node, the m24m02 driver 
+ *        itself is not a device driver, so an empty one is defined here. 
+ */
+static int m24m02_emul_dev_init(const struct device *dev) {
+    return 0;
+}
+
+#define M24M02_EMUL_DEFINE(inst) \
+    BUILD_ASSERT(DT_INST_PROP(inst, block_count) < M24M02_EMUL_BLOCK_MAX, "too many blocks"); \
+    BUILD_ASSERT(DT_INST_PROP(inst, pagesize) <= M24M02_EMUL_PAGE_SIZE_MAX, "page too large"); \
+    static uint8_t m24m02_emul_mem_##inst[DT_INST_PROP(inst, size)]; \
+    static struct m24m02_emul_data_st m24m02_emul_data_##inst; \
+    static const struct m24m02_emul_cfg_st m24m02_emul_cfg_##inst = { \
+        .addr = DT_INST_REG_ADDR(inst), \
+        .addr_step = DT_INST_PROP(inst, block_addr_step), \
+        .id_addr = DT_INST_PROP(inst, id_page_addr), \
+        .size = DT_INST_PROP(inst, size), \
+        .block_size = DT_INST_PROP(inst, size) / DT_INST_PROP(inst, block_count), \
+        .page_size = DT_INST_PROP(inst, pagesize), \
+        .block_count = DT_INST_PROP(inst, block_count), \
+        .read_across_blocks = DT_INST_PROP(inst, read_across_blocks), \
+        .mem = m24m02_emul_mem_##inst, \
+    }; \
+    DEVICE_DT_INST_DEFINE(inst, m24m02_emul_dev_init, NULL, NULL, NULL, POST_KERNEL, \
+            CONFIG_APPLICATION_INIT_PRIORITY, NULL); \
+    EMUL_DT_INST_DEFINE(inst, m24m02_emul_init, &m24m02_emul_data_##inst, &m24m02_emul_cfg_##inst, \
+            &m24m02_emul_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(M24M02_EMUL_DEFINE)
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef _M24M02_EMUL_H_
+#define _M24M02_EMUL_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/drivers/emul.h>
+
+#define DT_DRV_COMPAT cubewatch_m24xx
+
+#define M24M02_EMUL_BLOCK_MAX 8
+#define M24M02_EMUL_PAGE_SIZE_MAX 256
+#define M24M02_EMUL_START_STOP_BITS 2                                                               // START or RESTART, STOP
+
+struct m24m02_emul_cfg_st {
+    uint16_t addr;                                                                                  // device select code of block 0
+    uint8_t addr_step;
+    uint16_t id_addr;                                                                               // 0: no identification page
+    uint32_t size;
+    uint32_t block_size;
+    uint16_t page_size;
+    uint8_t block_count;
+    bool read_across_blocks;
+    uint8_t *mem;                                                                                   // array content
+};
+
+struct m24m02_emul_data_st {
+    struct i2c_emul extra[M24M02_EMUL_BLOCK_MAX];                                                   // blocks 1-n and identification page
+    const struct device *bus;
+    uint8_t id_page[M24M02_EMUL_PAGE_SIZE_MAX];
+    uint32_t counter;                                                                               // internal address counter
+    uint16_t id_counter;
+    int64_t busy_until_us;                                                                          // write cycle end
+    uint32_t page_writes;
+    uint32_t nacks;                                                                                 // device select while busy
+};
+
+BUILD_ASSERT(CONFIG_M24M02_EMUL_XFER_MAX == 0 || CONFIG_M24M02_EMUL_XFER_MAX >= 3, 
+        "transfer limit must hold 2 address byte and 1 data byte");
+
+static int64_t m24m02_emul_now_us(void);
+static void m24m02_emul_bus_time(const struct m24m02_emul_data_st *data, struct i2c_msg *msgs, 
+        int num_msgs);
+static int m24m02_emul_write(const struct m24m02_emul_cfg_st *cfg, struct m24m02_emul_data_st *data, 
+        uint8_t block, bool id, struct i2c_msg *msgs, int num_msgs);
+static void m24m02_emul_read(const struct m24m02_emul_cfg_st *cfg, struct m24m02_emul_data_st *data, 
+        bool id, uint8_t *buf, uint32_t length);
+static int m24m02_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs, 
+        int addr);
+static int m24m02_emul_init(const struct emul *target, const struct device *parent);
+
+#endif
\ No newline at end of file
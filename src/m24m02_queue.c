@@ -0,0 +1,113 @@
+/*
+ * @brief This file queues m24m02 writes and programs them in a low priority thread, 
+ *        so callers (e.g. BLE GATT write handlers) do not block during write cycles. 
+ */
+#include "m24m02_queue.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_queue, LOG_LEVEL_ERR);
+
+K_MSGQ_DEFINE(m24m02_queue_msgq, sizeof(struct m24m02_write_req_st), M24M02_QUEUE_DEPTH, 4);
+
+K_THREAD_DEFINE(m24m02_queue_thread_id, M24M02_QUEUE_STACKSIZE, m24m02_queue_thread, 
+        NULL, NULL, NULL, M24M02_QUEUE_PRIORITY, 0, 0);
+
+/*
+ * @brief queue thread, program requests one by one
+ */
+static void m24m02_queue_thread(void) {
+    struct m24m02_write_req_st req;
+
+    while (1) {
+        k_msgq_get(&m24m02_queue_msgq, &req, K_FOREVER);
+
+        int result = m24m02_write(req.addr, req.buf, req.length);
+        if (result) {
+            LOG_ERR("async write 0x%.05x, %d byte failed!", req.addr, req.length);
+        }
+
+        if (req.cb != NULL) {
+            req.cb(result, req.addr, req.buf, req.length, req.user_data);
+        }
+
+        if (req.signal != NULL) {
+            k_poll_signal_raise(req.signal, result);
+        }
+    }
+}
+
+/*
+ * @brief put a request into the queue, never blocks
+ *
+ * @param req request
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, queue is full
+ */
+static int m24m02_queue_submit(struct m24m02_write_req_st *req) {
+    if (k_msgq_put(&m24m02_queue_msgq, req, K_NO_WAIT)) {
+        LOG_ERR("queue full!");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief m24m02 asynchronous write, completion reported by callback
+ *        buf is not copied and must stay valid until cb is called. 
+ *        cb runs in the queue thread. 
+ *
+ * @param addr A17-A0 address
+ * @param buf data buffer
+ * @param length data length
+ * @param cb completion callback, may be NULL
+ * @param user_data passed to cb
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, queue is full
+ */
+int m24m02_write_async(uint32_t addr, uint8_t *buf, size_t length, 
+        m24m02_write_cb_t cb, void *user_data) {
+    struct m24m02_write_req_st req = {
+        .addr = addr, 
+        .buf = buf, 
+        .length = length, 
+        .cb = cb, 
+        .user_data = user_data, 
+        .signal = NULL, 
+    };
+
+    return m24m02_queue_submit(&req);
+}
+
+/*
+ * @brief m24m02 asynchronous write, completion reported by k_poll signal
+ *        buf is not copied and must stay valid until signal is raised, 
+ *        signal result is 0 when succeed and -1 when failed. 
+ *
+ * @param addr A17-A0 address
+ * @param buf data buffer
+ * @param length data length
+ * @param signal raised when the write lands
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, queue is full
+ */
+int m24m02_write_async_signal(uint32_t addr, uint8_t *buf, size_t length, 
+        struct k_poll_signal *signal) {
+    struct m24m02_write_req_st req = {
+        .addr = addr, 
+        .buf = buf, 
+        .length = length, 
+        .cb = NULL, 
+        .user_data = NULL, 
+        .signal = signal, 
+    };
+
+    return m24m02_queue_submit(&req);
+}
\ No newline at end of file
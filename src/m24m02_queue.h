@@ -0,0 +1,24 @@
+#ifndef _M24M02_QUEUE_H_
+#define _M24M02_QUEUE_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define M24M02_QUEUE_DEPTH 8
+#define M24M02_QUEUE_STACKSIZE 1024
+#define M24M02_QUEUE_PRIORITY 10                                                                    // lower than write screen thread
+
+struct m24m02_write_req_st {
+    uint32_t addr;
+    uint8_t *buf;
+    size_t length;
+    m24m02_write_cb_t cb;
+    void *user_data;
+    struct k_poll_signal *signal;
+};
+
+static void m24m02_queue_thread(void);
+static int m24m02_queue_submit(struct m24m02_write_req_st *req);
+
+#endif
\ No newline at end of file
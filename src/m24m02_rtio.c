@@ -0,0 +1,173 @@
+/*
+ * @brief This file is a RTIO front end of m24m02, m24m02_iodev. 
+ *        a request is a transaction of 2 sqe, a tiny write of the A17-A0 address 
+ *        (like the address byte on the wire) and a read or write of the data, 
+ *        see m24m02_rtio_prep_read() / m24m02_rtio_prep_write(). 
+ *        requests are run by one thread through m24m02_read() / m24m02_write(), 
+ *        so they share the bus lock, page cache and ACK polling with blocking callers. 
+ *        chained requests are run back to back by that thread without a context switch, 
+ *        consumers pick up completions with rtio_cqe_consume() from their own loop. 
+ */
+#include "m24m02_rtio.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_rtio, LOG_LEVEL_ERR);
+
+static const struct rtio_iodev_api m24m02_iodev_api = {
+    .submit = m24m02_iodev_submit, 
+};
+
+RTIO_IODEV_DEFINE(m24m02_iodev, &m24m02_iodev_api, NULL);
+
+K_MSGQ_DEFINE(m24m02_rtio_msgq, sizeof(struct rtio_iodev_sqe *), M24M02_RTIO_QUEUE_DEPTH, 4);
+
+K_THREAD_DEFINE(m24m02_rtio_thread_id, M24M02_RTIO_STACKSIZE, m24m02_rtio_thread, 
+        NULL, NULL, NULL, M24M02_RTIO_PRIORITY, 0, 0);
+
+/*
+ * @brief iodev submit, called by the RTIO executor, maybe from an ISR, never blocks
+ *
+ * @param iodev_sqe first sqe of the transaction
+ */
+static void m24m02_iodev_submit(struct rtio_iodev_sqe *iodev_sqe) {
+    if (k_msgq_put(&m24m02_rtio_msgq, &iodev_sqe, K_NO_WAIT)) {
+        LOG_ERR("rtio queue full!");
+        rtio_iodev_sqe_err(iodev_sqe, -ENOMEM);
+    }
+}
+
+/*
+ * @brief rtio thread, run transactions one by one
+ *        completing a transaction submits the next chained one into the queue 
+ *        at once, so a chain is run without waiting for a new submission. 
+ */
+static void m24m02_rtio_thread(void) {
+    struct rtio_iodev_sqe *iodev_sqe;
+
+    while (1) {
+        k_msgq_get(&m24m02_rtio_msgq, &iodev_sqe, K_FOREVER);
+
+        int result = m24m02_rtio_exec(iodev_sqe);
+        if (result) {
+            rtio_iodev_sqe_err(iodev_sqe, result);
+        } else {
+            rtio_iodev_sqe_ok(iodev_sqe, 0);
+        }
+    }
+}
+
+/*
+ * @brief run one transaction, address sqe then data sqe
+ *
+ * @param iodev_sqe first sqe of the transaction
+ *
+ * @retval 0 succeed
+ * @retval -EINVAL malformed transaction
+ * @retval -EIO i2c failed
+ */
+static int m24m02_rtio_exec(struct rtio_iodev_sqe *iodev_sqe) {
+    const struct rtio_sqe *addr_sqe = &iodev_sqe->sqe;
+    struct rtio_iodev_sqe *data_iodev_sqe = rtio_txn_next(iodev_sqe);
+    const struct rtio_sqe *sqe;
+    uint32_t addr;
+
+    if (addr_sqe->op != RTIO_OP_TINY_TX || addr_sqe->tiny_tx.buf_len != sizeof(addr) 
+            || data_iodev_sqe == NULL) {
+        return -EINVAL;
+    }
+
+    memcpy(&addr, addr_sqe->tiny_tx.buf, sizeof(addr));
+    sqe = &data_iodev_sqe->sqe;
+
+    switch (sqe->op) {
+        case RTIO_OP_RX:
+            return m24m02_read(addr, sqe->rx.buf, sqe->rx.buf_len) ? -EIO : 0;
+        case RTIO_OP_TX:
+            return m24m02_write(addr, (uint8_t *)sqe->tx.buf, sqe->tx.buf_len) ? -EIO : 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+/*
+ * @brief acquire the 2 sqe of a request, prepare the address sqe
+ *
+ * @param r RTIO context
+ * @param addr A17-A0 address
+ * @param data_sqe where the data sqe will be written to
+ *
+ * @retval address sqe, NULL if the submission queue is full
+ */
+static struct rtio_sqe *m24m02_rtio_prep(struct rtio *r, uint32_t addr, struct rtio_sqe **data_sqe) {
+    struct rtio_sqe *addr_sqe;
+
+    if (rtio_sqe_acquirable(r) < 2) {
+        return NULL;
+    }
+
+    addr_sqe = rtio_sqe_acquire(r);
+    *data_sqe = rtio_sqe_acquire(r);
+
+    rtio_sqe_prep_tiny_write(addr_sqe, &m24m02_iodev, RTIO_PRIO_NORM, 
+            (const uint8_t *)&addr, sizeof(addr), NULL);
+    addr_sqe->flags |= RTIO_SQE_TRANSACTION | RTIO_SQE_NO_RESPONSE;                                 // 1 completion per request
+
+    return addr_sqe;
+}
+
+/*
+ * @brief queue a read request, rtio_submit() starts it
+ *        set RTIO_SQE_CHAINED on the returned sqe to run the next request after it. 
+ *
+ * @param r RTIO context
+ * @param addr A17-A0 address
+ * @param buf where data will be written to
+ * @param length data length
+ * @param userdata passed to the completion
+ *
+ * @retval data sqe
+ * @retval NULL failed, submission queue is full
+ */
+struct rtio_sqe *m24m02_rtio_prep_read(struct rtio *r, uint32_t addr, uint8_t *buf, size_t length, 
+        void *userdata) {
+    struct rtio_sqe *data_sqe;
+
+    if (m24m02_rtio_prep(r, addr, &data_sqe) == NULL) {
+        return NULL;
+    }
+
+    rtio_sqe_prep_read(data_sqe, &m24m02_iodev, RTIO_PRIO_NORM, buf, length, userdata);
+
+    return data_sqe;
+}
+
+/*
+ * @brief queue a write request, rtio_submit() starts it
+ *        set RTIO_SQE_CHAINED on the returned sqe to run the next request after it. 
+ *
+ * @param r RTIO context
+ * @param addr A17-A0 address
+ * @param buf data buffer, must stay valid until completion
+ * @param length data length
+ * @param userdata passed to the completion
+ *
+ * @retval data sqe
+ * @retval NULL failed, submission queue is full
+ */
+struct rtio_sqe *m24m02_rtio_prep_write(struct rtio *r, uint32_t addr, const uint8_t *buf, 
+        size_t length, void *userdata) {
+    struct rtio_sqe *data_sqe;
+
+    if (m24m02_rtio_prep(r, addr, &data_sqe) == NULL) {
+        return NULL;
+    }
+
+    rtio_sqe_prep_write(data_sqe, &m24m02_iodev, RTIO_PRIO_NORM, buf, length, userdata);
+
+    return data_sqe;
+}
\ No newline at end of file
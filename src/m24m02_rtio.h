@@ -0,0 +1,18 @@
+#ifndef _M24M02_RTIO_H_
+#define _M24M02_RTIO_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+
+#include "common.h"
+
+#define M24M02_RTIO_QUEUE_DEPTH 8                                                                   // transactions waiting
+#define M24M02_RTIO_STACKSIZE 1024
+#define M24M02_RTIO_PRIORITY 10                                                                     // lower than write screen thread
+
+static void m24m02_rtio_thread(void);
+static void m24m02_iodev_submit(struct rtio_iodev_sqe *iodev_sqe);
+static int m24m02_rtio_exec(struct rtio_iodev_sqe *iodev_sqe);
+static struct rtio_sqe *m24m02_rtio_prep(struct rtio *r, uint32_t addr, struct rtio_sqe **data_sqe);
+
+#endif
\ No newline at end of file
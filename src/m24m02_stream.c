@@ -0,0 +1,206 @@
+/*
+ * @brief This file streams long assets (images, fonts) out of m24m02. 
+ *        consecutive m24m02_stream_read calls continue where the last one ended, 
+ *        so the driver uses current address reads and skips the address phase. 
+ *        a crc32 of the streamed bytes is kept on the way, see asset_verify(). 
+ */
+#include "m24m02_stream.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_stream, LOG_LEVEL_ERR);
+
+/*
+ * @brief open a stream
+ *        dirty pages of a write-back cache are programmed first, 
+ *        stream reads go to the bus and bypass the page cache. 
+ *
+ * @param stream stream to open
+ * @param addr A17-A0 start address
+ * @param length stream length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_stream_open(struct m24m02_stream_st *stream, uint32_t addr, size_t length) {
+    if (addr > M24M02_SIZE || length > M24M02_SIZE - addr) {
+        LOG_ERR("stream address check failed!");
+        return -1;
+    }
+
+    if (m24m02_cache_flush()) {
+        return -1;
+    }
+
+    stream->addr = addr;
+    stream->end = addr + length;
+    stream->crc = 0;
+
+    return 0;
+}
+
+/*
+ * @brief read the next bytes of a stream
+ *
+ * @param stream opened stream
+ * @param buf where data will be written to
+ * @param length max data length
+ *
+ * @retval byte read, 0 at the end of stream
+ * @retval -1 failed
+ */
+int m24m02_stream_read(struct m24m02_stream_st *stream, uint8_t *buf, size_t length) {
+    size_t chunk = MIN(length, stream->end - stream->addr);
+
+    if (chunk == 0) {
+        return 0;
+    }
+
+    if (m24m02_bus_read(stream->addr, buf, chunk)) {
+        return -1;
+    }
+
+    stream->addr += chunk;
+    stream->crc = crc32_update(stream->crc, buf, chunk);
+
+    return chunk;
+}
+
+K_MSGQ_DEFINE(m24m02_prefetch_msgq, sizeof(struct m24m02_prefetch_req_st), 
+        M24M02_PREFETCH_QUEUE_DEPTH, 4);
+
+K_THREAD_DEFINE(m24m02_prefetch_thread_id, M24M02_PREFETCH_STACKSIZE, m24m02_prefetch_thread, 
+        NULL, NULL, NULL, M24M02_PREFETCH_PRIORITY, 0, 0);
+
+/*
+ * @brief prefetch thread, fill buffers in request order so the stream stays sequential
+ */
+static void m24m02_prefetch_thread(void) {
+    struct m24m02_prefetch_req_st req;
+
+    while (1) {
+        k_msgq_get(&m24m02_prefetch_msgq, &req, K_FOREVER);
+        m24m02_prefetch_fill(req.pf, req.index);
+    }
+}
+
+/*
+ * @brief read the next stream bytes into one buffer, then mark it ready
+ *
+ * @param pf prefetch stream
+ * @param index buffer to fill
+ */
+static void m24m02_prefetch_fill(struct m24m02_prefetch_st *pf, uint8_t index) {
+    pf->length[index] = m24m02_stream_read(&pf->stream, pf->buf[index], sizeof(pf->buf[index]));
+    k_sem_give(&pf->ready[index]);
+}
+
+/*
+ * @brief start fetching into one buffer in the background
+ *        waits for room when the request queue is full, a fill in the caller 
+ *        would run ahead of the request still queued for the other buffer, 
+ *        and the stream address / crc would be updated by two threads. 
+ *
+ * @param pf prefetch stream
+ * @param index buffer to fill
+ */
+static void m24m02_prefetch_submit(struct m24m02_prefetch_st *pf, uint8_t index) {
+    struct m24m02_prefetch_req_st req = {
+        .pf = pf, 
+        .index = index, 
+    };
+
+    pf->pending |= BIT(index);
+
+    k_msgq_put(&m24m02_prefetch_msgq, &req, K_FOREVER);
+}
+
+/*
+ * @brief open a prefetch stream, both buffers start fetching at once
+ *
+ * @param pf prefetch stream
+ * @param addr A17-A0 start address
+ * @param length stream length
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_prefetch_open(struct m24m02_prefetch_st *pf, uint32_t addr, size_t length) {
+    if (m24m02_stream_open(&pf->stream, addr, length)) {
+        return -1;
+    }
+
+    k_sem_init(&pf->ready[0], 0, 1);
+    k_sem_init(&pf->ready[1], 0, 1);
+    pf->curr = 0;
+    pf->pending = 0;
+    pf->stall_us = 0;
+    pf->stalls = 0;
+
+    m24m02_prefetch_submit(pf, 0);
+    m24m02_prefetch_submit(pf, 1);
+
+    return 0;
+}
+
+/*
+ * @brief get the current buffer, wait if it is still being fetched
+ *        the wait is accumulated in pf->stall_us. 
+ *
+ * @param pf prefetch stream
+ * @param data where the buffer pointer will be written to
+ *
+ * @retval byte in buffer, 0 at the end of stream
+ * @retval -1 failed
+ */
+int m24m02_prefetch_get(struct m24m02_prefetch_st *pf, uint8_t **data) {
+    uint8_t index = pf->curr;
+
+    if (k_sem_take(&pf->ready[index], K_NO_WAIT)) {                                                 // not hidden, stall
+        uint32_t start = k_cycle_get_32();
+
+        k_sem_take(&pf->ready[index], K_FOREVER);
+
+        pf->stall_us += k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        pf->stalls++;
+    }
+    k_sem_give(&pf->ready[index]);                                                                  // stays ready until release
+
+    *data = pf->buf[index];
+
+    return pf->length[index];
+}
+
+/*
+ * @brief consumer is done with the current buffer, refill it in the background 
+ *        and move to the other buffer
+ *
+ * @param pf prefetch stream
+ */
+void m24m02_prefetch_release(struct m24m02_prefetch_st *pf) {
+    uint8_t index = pf->curr;
+
+    k_sem_take(&pf->ready[index], K_FOREVER);
+
+    m24m02_prefetch_submit(pf, index);
+    pf->curr ^= 1;
+}
+
+/*
+ * @brief close a prefetch stream, wait for background fetches still running
+ *
+ * @param pf prefetch stream
+ */
+void m24m02_prefetch_close(struct m24m02_prefetch_st *pf) {
+    for (uint8_t i = 0; i < 2; i++) {
+        if (pf->pending & BIT(i)) {
+            k_sem_take(&pf->ready[i], K_FOREVER);
+            pf->pending &= ~BIT(i);
+        }
+    }
+
+    LOG_DBG("prefetch stall %u us in %u waits...", pf->stall_us, pf->stalls);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef _M24M02_STREAM_H_
+#define _M24M02_STREAM_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define M24M02_PREFETCH_QUEUE_DEPTH 4
+#define M24M02_PREFETCH_STACKSIZE 1024
+#define M24M02_PREFETCH_PRIORITY 6                                                                  // higher than write screen thread
+
+struct m24m02_prefetch_req_st {
+    struct m24m02_prefetch_st *pf;
+    uint8_t index;                                                                                  // buffer to fill
+};
+
+static void m24m02_prefetch_thread(void);
+static void m24m02_prefetch_fill(struct m24m02_prefetch_st *pf, uint8_t index);
+static void m24m02_prefetch_submit(struct m24m02_prefetch_st *pf, uint8_t index);
+
+#endif
\ No newline at end of file
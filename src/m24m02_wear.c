@@ -0,0 +1,210 @@
+/*
+ * @brief This file keeps a program cycle counter for every m24m02 page, 
+ *        persisted as 1024 uint32 in the reserved wear region (16 pages). 
+ *        the driver counts each page write in RAM (uint8 delta per page), 
+ *        the deltas are added to the stored counters in batches, 
+ *        one write cycle per dirty table page, periodically, 
+ *        when a delta gets large or on explicit flush. 
+ *        pages of the wear region itself are not counted. 
+ */
+#include "m24m02_wear.h"
+#include "common.h"
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(m24m02_wear, LOG_LEVEL_ERR);
+
+K_MUTEX_DEFINE(m24m02_wear_lock);
+K_WORK_DELAYABLE_DEFINE(m24m02_wear_flush_work, m24m02_wear_flush_work_handler);
+
+/*
+ * @brief wear statistics init func, start periodic flushing
+ *
+ * @retval 0 succeed
+ */
+int m24m02_wear_init(void) {
+    k_work_schedule(&m24m02_wear_flush_work, K_SECONDS(CONFIG_M24M02_WEAR_FLUSH_INTERVAL_S));
+
+    return 0;
+}
+
+/*
+ * @brief count one program cycle of a page, called by the driver after each page write
+ *        only touches RAM, safe from any thread. 
+ *
+ * @param addr linear address in the page
+ */
+void m24m02_wear_count(uint32_t addr) {
+    uint16_t page = addr / M24M02_WEAR_PAGE_SIZE;
+    k_spinlock_key_t key;
+    bool full = false;
+
+    if (page >= M24M02_WEAR_FIRST_PAGE) {                                                           // table, not counted
+        return;
+    }
+
+    key = k_spin_lock(&m24m02_wear_spinlock);
+    if (m24m02_wear_pending[page] < UINT8_MAX) {
+        m24m02_wear_pending[page]++;
+    }
+    m24m02_wear_dirty |= BIT(page / M24M02_WEAR_COUNTERS_PER_PAGE);
+    full = m24m02_wear_pending[page] >= M24M02_WEAR_PENDING_MAX;
+    k_spin_unlock(&m24m02_wear_spinlock, key);
+
+    if (full) {
+        k_work_reschedule(&m24m02_wear_flush_work, K_NO_WAIT);
+    }
+}
+
+/*
+ * @brief add the pending deltas of one table page to the stored counters
+ *        caller holds m24m02_wear_lock. 
+ *
+ * @param table_page 0-15
+ *
+ * @retval 0 succeed
+ * @retval -1 failed, deltas are kept
+ */
+static int m24m02_wear_flush_table_page(uint8_t table_page) {
+    uint16_t first = table_page * M24M02_WEAR_COUNTERS_PER_PAGE;
+    uint32_t addr = M24M02_WEAR_ADDR + table_page * M24M02_WEAR_PAGE_SIZE;
+    uint8_t delta[M24M02_WEAR_COUNTERS_PER_PAGE];
+    k_spinlock_key_t key;
+
+    if (m24m02_bus_read(addr, (uint8_t *)m24m02_wear_table_buf, sizeof(m24m02_wear_table_buf))) {
+        return -1;
+    }
+
+    key = k_spin_lock(&m24m02_wear_spinlock);                                                       // take the deltas
+    memcpy(delta, &m24m02_wear_pending[first], sizeof(delta));
+    memset(&m24m02_wear_pending[first], 0, sizeof(delta));
+    m24m02_wear_dirty &= ~BIT(table_page);
+    k_spin_unlock(&m24m02_wear_spinlock, key);
+
+    for (size_t i = 0; i < M24M02_WEAR_COUNTERS_PER_PAGE; i++) {
+        if (m24m02_wear_table_buf[i] == M24M02_WEAR_ERASED) {
+            m24m02_wear_table_buf[i] = 0;
+        }
+        m24m02_wear_table_buf[i] += delta[i];
+    }
+
+    if (m24m02_bus_write(addr, (uint8_t *)m24m02_wear_table_buf, sizeof(m24m02_wear_table_buf))) {
+        key = k_spin_lock(&m24m02_wear_spinlock);                                                   // give them back
+        for (size_t i = 0; i < M24M02_WEAR_COUNTERS_PER_PAGE; i++) {
+            m24m02_wear_pending[first + i] = MIN(m24m02_wear_pending[first + i] + delta[i], UINT8_MAX);
+        }
+        m24m02_wear_dirty |= BIT(table_page);
+        k_spin_unlock(&m24m02_wear_spinlock, key);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * @brief write all pending deltas to the wear table
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_wear_flush(void) {
+    int ret = 0;
+
+    k_mutex_lock(&m24m02_wear_lock, K_FOREVER);
+
+    for (uint8_t i = 0; i < M24M02_WEAR_TABLE_PAGES; i++) {
+        if ((m24m02_wear_dirty & BIT(i)) && m24m02_wear_flush_table_page(i)) {
+            LOG_ERR("wear table page %d flush failed!", i);
+            ret = -1;
+        }
+    }
+
+    k_mutex_unlock(&m24m02_wear_lock);
+
+    return ret;
+}
+
+static void m24m02_wear_flush_work_handler(struct k_work *work) {
+    m24m02_wear_flush();
+
+    k_work_schedule(&m24m02_wear_flush_work, K_SECONDS(CONFIG_M24M02_WEAR_FLUSH_INTERVAL_S));
+}
+
+/*
+ * @brief get the program cycle count of a page, stored plus pending
+ *
+ * @param page page number, A17-A8
+ * @param count where the count will be written to
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_wear_get(uint16_t page, uint32_t *count) {
+    uint32_t stored;
+
+    if (page >= M24M02_WEAR_FIRST_PAGE) {
+        return -1;
+    }
+
+    k_mutex_lock(&m24m02_wear_lock, K_FOREVER);                                                     // no flush in between
+
+    if (m24m02_bus_read(M24M02_WEAR_ADDR + page * sizeof(uint32_t), (uint8_t *)&stored, sizeof(stored))) {
+        k_mutex_unlock(&m24m02_wear_lock);
+        return -1;
+    }
+
+    *count = (stored == M24M02_WEAR_ERASED ? 0 : stored) + m24m02_wear_pending[page];
+
+    k_mutex_unlock(&m24m02_wear_lock);
+
+    return 0;
+}
+
+/*
+ * @brief find the most programmed page, to place hot data by measured wear
+ *
+ * @param page where the page number will be written to
+ * @param count where its count will be written to
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int m24m02_wear_hottest(uint16_t *page, uint32_t *count) {
+    int ret = 0;
+
+    *page = 0;
+    *count = 0;
+
+    k_mutex_lock(&m24m02_wear_lock, K_FOREVER);
+
+    for (uint8_t i = 0; i < M24M02_WEAR_TABLE_PAGES; i++) {
+        uint32_t addr = M24M02_WEAR_ADDR + i * M24M02_WEAR_PAGE_SIZE;
+
+        if (m24m02_bus_read(addr, (uint8_t *)m24m02_wear_table_buf, sizeof(m24m02_wear_table_buf))) {
+            ret = -1;
+            break;
+        }
+
+        for (size_t j = 0; j < M24M02_WEAR_COUNTERS_PER_PAGE; j++) {
+            uint16_t p = i * M24M02_WEAR_COUNTERS_PER_PAGE + j;
+            uint32_t c;
+
+            if (p >= M24M02_WEAR_FIRST_PAGE) {
+                break;
+            }
+
+            c = m24m02_wear_table_buf[j] == M24M02_WEAR_ERASED ? 0 : m24m02_wear_table_buf[j];
+            c += m24m02_wear_pending[p];
+            if (c > *count) {
+                *page = p;
+                *count = c;
+            }
+        }
+    }
+
+    k_mutex_unlock(&m24m02_wear_lock);
+
+    return ret;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef _M24M02_WEAR_H_
+#define _M24M02_WEAR_H_
+
+#include <zephyr/kernel.h>
+
+#include "common.h"
+
+#define M24M02_WEAR_PAGE_SIZE 256
+#define M24M02_WEAR_PAGE_COUNT (M24M02_SIZE / M24M02_WEAR_PAGE_SIZE)                                // 1024 pages
+#define M24M02_WEAR_COUNTERS_PER_PAGE (M24M02_WEAR_PAGE_SIZE / sizeof(uint32_t))                    // 64
+#define M24M02_WEAR_TABLE_PAGES (M24M02_WEAR_PAGE_COUNT / M24M02_WEAR_COUNTERS_PER_PAGE)            // 16
+#define M24M02_WEAR_FIRST_PAGE (M24M02_WEAR_ADDR / M24M02_WEAR_PAGE_SIZE)
+#define M24M02_WEAR_PENDING_MAX 192                                                                 // flush early, uint8 delta
+#define M24M02_WEAR_ERASED 0xFFFFFFFF                                                               // never flushed, 0
+
+BUILD_ASSERT(M24M02_WEAR_TABLE_PAGES * M24M02_WEAR_PAGE_SIZE == M24M02_WEAR_SIZE, 
+        "wear table must fill the reserved wear region");
+BUILD_ASSERT(M24M02_WEAR_TABLE_PAGES <= 32, "1 dirty bit per table page");
+
+static uint8_t m24m02_wear_pending[M24M02_WEAR_PAGE_COUNT];                                         // program cycles not flushed
+static uint32_t m24m02_wear_dirty;                                                                  // 1 bit per table page
+static struct k_spinlock m24m02_wear_spinlock;
+static uint32_t m24m02_wear_table_buf[M24M02_WEAR_COUNTERS_PER_PAGE];
+
+static void m24m02_wear_flush_work_handler(struct k_work *work);
+static int m24m02_wear_flush_table_page(uint8_t table_page);
+
+#endif
\ No newline at end of file
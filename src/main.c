@@ -54,16 +54,48 @@ int main(void)
 	}
 	LOG_DBG("m24m02 init succeed!");
 
+#if defined(CONFIG_M24M02_BENCH)
+	if(m24m02_bench(NULL)) {
+		LOG_ERR("m24m02 benchmark failed!");
+	}
+#endif
+
+#if defined(CONFIG_M24M02_WEAR_STATS)
+	if(m24m02_wear_init()) {
+		LOG_ERR("m24m02 wear statistics init failed!");
+		return -1;
+	}
+#endif
+
+	if(m24m02_coalesce_init()) {
+		LOG_ERR("m24m02 coalesce init failed!");
+		return -1;
+	}
+
+	if(asset_dir_init()) {
+		LOG_ERR("asset directory init failed!");
+		return -1;
+	}
+
+	if(kvs_init()) {
+		LOG_ERR("kvs init failed!");
+		return -1;
+	}
+
+#if defined(CONFIG_SPI)
 	if(st7735_init()) {
 		LOG_ERR("st7735 init failed!");
 		return -1;
 	}
 	LOG_DBG("st7735 init succeed!");
+#endif
 
+#if defined(CONFIG_BT)
 	if(nrf52832_init()) {
 		LOG_ERR("nrf52832 init failed!");
 		return -1;
 	}
+#endif
 
 	if (led_init()) {
 		LOG_ERR("led init failed!");
@@ -12,6 +12,8 @@
 
 LOG_MODULE_REGISTER(nrf52, LOG_LEVEL_DBG);
 
+K_WORK_DEFINE(font_upload_done_work, font_upload_done);
+
 static struct bt_le_adv_param *adv_param = BT_LE_ADV_PARAM(
 	    (BT_LE_ADV_OPT_CONNECTABLE |
 	    BT_LE_ADV_OPT_USE_IDENTITY),                                                                // Connectable advertising and use identity address
@@ -57,8 +59,23 @@ static ssize_t calibrate_time(struct bt_conn *conn, const struct bt_gatt_attr *a
 	return len;
 }
 
+/*
+ * @brief font chunks are appended at font_upload_addr, 
+ *        gathered per page in RAM and programmed as one page write by the m24m02 queue thread, 
+ *        so the BT RX context does not wait for write cycles. 
+ *        when both page buffers are still being programmed the chunk is refused 
+ *        with insufficient resources and the peer sends it again. 
+ */
 static ssize_t customize_font(struct bt_conn *conn, const struct bt_gatt_attr *attr, 
 		const void *buf, uint16_t len, uint16_t offset, uint8_t flags) {
+	if (font_upload_addr + len > CW_FONT_EEPROM_ADDR + CW_FONT_EEPROM_SIZE) {
+		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+	}
+
+	if (m24m02_coalesce_write(font_upload_addr, buf, len)) {
+		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+	}
+	font_upload_addr += len;
 
 	return len;
 }
@@ -91,20 +108,32 @@ static void on_connected(struct bt_conn *conn, uint8_t err) {
 		LOG_ERR("Connection failed (err %u)", err);
 		return;
 	}
+	font_upload_addr = CW_FONT_EEPROM_ADDR;
     write_screen_thread_suspend();
     LOG_DBG("Connection succeed!");
 }
 
 /*
- * @brief if disconnected
+ * @brief font upload ended, program the last page and resume the screen, 
+ *        runs in the system workqueue so BT RX does not wait for write cycles
  */
-static void on_disconnected(struct bt_conn *conn, uint8_t reason) {
-	LOG_DBG("Disconnected (reason %u)", reason);
+static void font_upload_done(struct k_work *work) {
+	if (m24m02_coalesce_flush()) {
+		LOG_ERR("font upload flush failed!");
+	}
 	ds3231_time_read();
 	// st7735_screen_write();
     write_screen_thread_resume();
 }
 
+/*
+ * @brief if disconnected
+ */
+static void on_disconnected(struct bt_conn *conn, uint8_t reason) {
+	LOG_DBG("Disconnected (reason %u)", reason);
+	k_work_submit(&font_upload_done_work);
+}
+
 /*
  * @brief connection callbacks
  */
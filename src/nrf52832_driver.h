@@ -1,6 +1,8 @@
 #ifndef _NRF52832_DRIVER_H_
 #define _NRF52832_DRIVER_H_
 
+#include <zephyr/kernel.h>
+
 #define CW_ADS_BT_UUID_VAL BT_UUID_128_ENCODE(0x00004200, 0x4200, 0x0000, 0x0052, 0x6F6265727453)	// CW (cube watch) ADS (advertising service)
 #define CW_ADS_BT_UUID BT_UUID_DECLARE_128(CW_ADS_BT_UUID_VAL)
 
@@ -16,4 +18,11 @@
 #define CW_FCC_BT_UUID_VAL BT_UUID_128_ENCODE(0x00004200, 0x4204, 0x0000, 0x0052, 0x6F6265727453)   // FCC (font customize characteristic)
 #define CW_FCC_BT_UUID BT_UUID_DECLARE_128(CW_FCC_BT_UUID_VAL)
 
+#define CW_FONT_EEPROM_ADDR 0x00000																	// font upload area in m24m02
+#define CW_FONT_EEPROM_SIZE 0x10000
+
+static uint32_t font_upload_addr = CW_FONT_EEPROM_ADDR;
+
+static void font_upload_done(struct k_work *work);
+
 #endif
\ No newline at end of file
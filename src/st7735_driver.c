@@ -10,6 +10,8 @@
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 
+#include <nrfx.h>
+
 LOG_MODULE_REGISTER(st7735, LOG_LEVEL_DBG);
 
 struct spi_dt_spec st7735_spispec = SPI_DT_SPEC_GET(DT_NODELABEL(st7735), 
@@ -21,6 +23,10 @@ struct gpio_dt_spec st7735_cmd_data_gpiospec = GPIO_DT_SPEC_GET_BY_IDX(
 struct gpio_dt_spec st7735_bk_gpiospec = GPIO_DT_SPEC_GET_BY_IDX(
         DT_NODELABEL(spi1), cs_gpios, 2);
 
+K_MUTEX_DEFINE(st7735_dirty_lock);
+K_MUTEX_DEFINE(st7735_draw_lock);																	// D/C, window and pixel data of one drawing call
+K_SEM_DEFINE(st7735_push_sem, 0, 1);
+
 /*
  * @brief st7735 main init func
  *
@@ -28,6 +34,8 @@ struct gpio_dt_spec st7735_bk_gpiospec = GPIO_DT_SPEC_GET_BY_IDX(
  * @retval -1 failed
  */
 int st7735_init(void) {
+	uint32_t start = k_uptime_get_32();
+
 	if(!spi_is_ready_dt(&st7735_spispec)) {
 		return -1;
 	}
@@ -52,10 +60,17 @@ int st7735_init(void) {
 		return -1;
 	}
 
+	if(gpio_pin_configure_dt(&st7735_cmd_data_gpiospec, GPIO_OUTPUT_ACTIVE)) {						// cmd mode, then only set
+		return -1;
+	}
+
 	if(st7735_reg_init()) {
 		return -1;
 	}
 
+	LOG_DBG("first pixel %u ms after boot, st7735 init %u ms", k_uptime_get_32(), 
+			k_uptime_get_32() - start);
+
 	return 0;
 }
 
@@ -66,124 +81,550 @@ int st7735_init(void) {
  * @retval -1 failed
  */
 static int st7735_reg_init(void) {
-	if(st7735_write(ST7735_SLPOUT_REG_BUF, sizeof(ST7735_SLPOUT_REG_BUF))) {
+	if(st7735_cmd_list_run(ST7735_INIT_CMD_LIST)) {
 		return -1;
 	}
 
-	if(st7735_write(ST7735_FRMCTR1_REG_BUF, sizeof(ST7735_FRMCTR1_REG_BUF))) {
+	if(st7735_fill_rect(0, 0, TFT144_COLUMN_PIXELS_MAX, TFT144_ROW_PIXELS_MAX, ST7735_COLOR_WHITE)) {
 		return -1;
 	}
 
-	if(st7735_write(ST7735_FRMCTR2_REG_BUF, sizeof(ST7735_FRMCTR2_REG_BUF))) {
-		return -1;
+	return 0;
+}
+
+/*
+ * @brief run a command list, see ST7735_INIT_CMD_LIST
+ *        st7735_draw_lock is held from the first command to the last, 
+ *        D/C is only set, it is configured as output once in st7735_init(). 
+ *
+ * @param list command list
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_cmd_list_run(const uint8_t *list) {
+	uint8_t args[ST7735_CMD_ARGS_MAX];																// EasyDMA can not read flash
+	uint8_t count = *list++;
+	uint8_t cmd;
+	uint8_t argc;
+	bool delay;
+	int ret = 0;
+
+	struct spi_buf tx_spi_buf;
+	struct spi_buf_set tx_spi_buf_set = {.buffers = &tx_spi_buf, .count = 1};
+
+	k_mutex_lock(&st7735_draw_lock, K_FOREVER);														// recursive, callers may hold it
+
+	for(uint8_t i = 0; i < count; i++) {
+		cmd = *list++;
+		argc = *list & ~ST7735_CMD_DELAY;
+		delay = *list++ & ST7735_CMD_DELAY;
+
+		if(argc > sizeof(args)) {
+			ret = -1;
+			break;
+		}
+
+		if(gpio_pin_set_dt(&st7735_cmd_data_gpiospec, 1)) {											// cmd mode
+			ret = -1;
+			break;
+		}
+
+		tx_spi_buf.buf = &cmd;
+		tx_spi_buf.len = 1;
+		if(spi_write_dt(&st7735_spispec, &tx_spi_buf_set)) {
+			ret = -1;
+			break;
+		}
+
+		if(argc) {
+			if(gpio_pin_set_dt(&st7735_cmd_data_gpiospec, 0)) {										// data mode
+				ret = -1;
+				break;
+			}
+
+			memcpy(args, list, argc);
+			tx_spi_buf.buf = args;
+			tx_spi_buf.len = argc;
+			if(spi_write_dt(&st7735_spispec, &tx_spi_buf_set)) {
+				ret = -1;
+				break;
+			}
+			list += argc;
+		}
+
+		if(delay) {
+			k_msleep(*list++);
+		}
 	}
 
-	if(st7735_write(ST7735_FRMCTR3_REG_BUF, sizeof(ST7735_FRMCTR3_REG_BUF))) {
+	k_mutex_unlock(&st7735_draw_lock);
+
+	return ret;
+}
+
+/*
+ * @brief write data of the last command, may be called repeatedly, 
+ *        e.g. RAMWR pixels in several parts
+ *
+ * @param data data
+ * @param length length of data
+ * 
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_data_write(const uint8_t *data, size_t length) {
+	if(gpio_pin_set_dt(&st7735_cmd_data_gpiospec, 0)){												// data mode
 		return -1;
 	}
 
-	if(st7735_write(ST7735_INVCTR_REG_BUF, sizeof(ST7735_INVCTR_REG_BUF))) {
+	struct spi_buf tx_spi_buf = { .buf = (void *)data, .len = length};
+	struct spi_buf_set tx_spi_buf_set = {.buffers = &tx_spi_buf, .count = 1};
+
+	if(spi_write_dt(&st7735_spispec, &tx_spi_buf_set)) {
 		return -1;
 	}
 
-	if(st7735_write(ST7735_PWCTR1_REG_BUF, sizeof(ST7735_PWCTR1_REG_BUF))) {
+	return 0;
+}
+
+/*
+ * @brief set the CASET / RASET window and start RAMWR, data then fills it row by row
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_window_set(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+	uint8_t list[ST7735_WINDOW_CMD_LIST_SIZE] = {
+		3, 
+		ST7735_CASET_REG, 4, 0x00, x, 0x00, x + w - 1, 
+		ST7735_RASET_REG, 4, 0x00, y, 0x00, y + h - 1, 
+		ST7735_RAMWR_REG, 0, 
+	};
+
+	return st7735_cmd_list_run(list);
+}
+
+/*
+ * @brief write pixels to a window of the screen
+ *
+ * @param x column of the top left pixel
+ * @param y row of the top left pixel
+ * @param w width
+ * @param h height
+ * @param pixels w * h RGB565 pixels, row by row, high byte first, in RAM or flash
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int st7735_blit(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint8_t *pixels) {
+	if(w == 0 || h == 0 || x + w > TFT144_COLUMN_PIXELS_MAX || y + h > TFT144_ROW_PIXELS_MAX) {
+		LOG_ERR("blit window out of the screen!");
 		return -1;
 	}
 
-	if(st7735_write(ST7735_PWCTR2_REG_BUF, sizeof(ST7735_PWCTR2_REG_BUF))) {
-		return -1;
+	if(!nrfx_is_in_ram(pixels)) {																	// flash, EasyDMA can not read it
+		return st7735_stream(x, y, w, h, st7735_flash_read, &pixels);
 	}
 
-	if(st7735_write(ST7735_PWCTR3_REG_BUF, sizeof(ST7735_PWCTR3_REG_BUF))) {
-		return -1;
+	int ret = 0;
+
+	k_mutex_lock(&st7735_draw_lock, K_FOREVER);
+
+	if(st7735_window_set(x, y, w, h) || st7735_data_write(pixels, w * h * ST7735_PIXEL_SIZE)) {
+		ret = -1;
 	}
 
-	if(st7735_write(ST7735_PWCTR4_REG_BUF, sizeof(ST7735_PWCTR4_REG_BUF))) {
+	k_mutex_unlock(&st7735_draw_lock);
+
+	return ret;
+}
+
+/*
+ * @brief fill a window of the screen with one color
+ *        the color is sent row by row from a one row RAM buffer. 
+ *
+ * @param x column of the top left pixel
+ * @param y row of the top left pixel
+ * @param w width
+ * @param h height
+ * @param color RGB565, ST7735_COLOR_xx
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int st7735_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color) {
+	if(w == 0 || h == 0 || x + w > TFT144_COLUMN_PIXELS_MAX || y + h > TFT144_ROW_PIXELS_MAX) {
+		LOG_ERR("fill window out of the screen!");
 		return -1;
 	}
 
-	if(st7735_write(ST7735_PWCTR5_REG_BUF, sizeof(ST7735_PWCTR5_REG_BUF))) {
-		return -1;
+	int ret = 0;
+
+	k_mutex_lock(&st7735_draw_lock, K_FOREVER);
+
+	for(uint8_t i = 0; i < w; i++) {
+		st7735_line_buf[i * ST7735_PIXEL_SIZE] = color >> 8;										// high byte first
+		st7735_line_buf[i * ST7735_PIXEL_SIZE + 1] = color & 0xFF;
 	}
 
-	if(st7735_write(ST7735_MADCTL_REG_BUF, sizeof(ST7735_MADCTL_REG_BUF))) {
-		return -1;
+	if(st7735_window_set(x, y, w, h)) {
+		ret = -1;
 	}
 
-	if(st7735_write(ST7735_GMCTRP1_REG_BUF, sizeof(ST7735_GMCTRP1_REG_BUF))) {
-		return -1;
+	for(uint8_t i = 0; i < h && !ret; i++) {
+		if(st7735_data_write(st7735_line_buf, w * ST7735_PIXEL_SIZE)) {
+			ret = -1;
+		}
 	}
 
-	if(st7735_write(ST7735_GMCTRN1_REG_BUF, sizeof(ST7735_GMCTRN1_REG_BUF))) {
+	k_mutex_unlock(&st7735_draw_lock);
+
+	return ret;
+}
+
+/*
+ * @brief spi transfer done, called from the spi interrupt
+ */
+static void st7735_push_done(const struct device *dev, int result, void *data) {
+	st7735_push_spi_cycles += k_cycle_get_32() - st7735_push_start;
+	st7735_push_result = result;
+	k_sem_give(&st7735_push_sem);
+}
+
+/*
+ * @brief start sending a line with SPIM EasyDMA, returns without waiting
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_push_line(uint8_t *line, size_t length) {
+	st7735_push_tx_buf.buf = line;
+	st7735_push_tx_buf.len = length;
+	st7735_push_start = k_cycle_get_32();
+
+	if(spi_transceive_cb(st7735_spispec.bus, &st7735_spispec.config, &st7735_push_tx_buf_set, NULL, 
+			st7735_push_done, NULL)) {
 		return -1;
 	}
 
-	if(st7735_write(ST7735_CASET_REG_BUF, sizeof(ST7735_CASET_REG_BUF))) {
+	return 0;
+}
+
+/*
+ * @brief wait for the line on the wire
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_push_wait(void) {
+	k_sem_take(&st7735_push_sem, K_FOREVER);
+
+	return st7735_push_result ? -1 : 0;
+}
+
+/*
+ * @brief write length byte of RAMWR data in chunks, double buffered
+ *        next fills chunk N + 1 into one buffer while chunk N is sent 
+ *        from the other one by SPIM EasyDMA. the time spent in next, on the wire 
+ *        and waiting for the wire is kept in st7735_push_stats. 
+ *
+ * @param length total byte
+ * @param chunk byte per buffer, at most sizeof(st7735_push_buf[0])
+ * @param next fills a chunk
+ * @param data passed to next
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_pump(size_t length, size_t chunk, st7735_chunk_cb_t next, void *data) {
+	uint32_t frame_start = k_cycle_get_32();
+	uint32_t cpu_cycles = 0;
+	uint32_t wait_cycles = 0;
+	uint32_t start;
+	bool busy = false;
+	uint8_t idx = 0;
+	int ret = 0;
+
+	if(gpio_pin_set_dt(&st7735_cmd_data_gpiospec, 0)){												// data mode
 		return -1;
 	}
 
-	if(st7735_write(ST7735_RASET_REG_BUF, sizeof(ST7735_RASET_REG_BUF))) {
-		return -1;
+	st7735_push_spi_cycles = 0;
+
+	for(uint32_t index = 0, done = 0; done < length; index++) {
+		size_t n = MIN(chunk, length - done);
+
+		start = k_cycle_get_32();
+		if(next(index, st7735_push_buf[idx], n, data)) {
+			ret = -1;
+			break;
+		}
+		cpu_cycles += k_cycle_get_32() - start;
+
+		if(busy) {																					// chunk N still on the wire
+			start = k_cycle_get_32();
+			busy = false;
+			if(st7735_push_wait()) {
+				ret = -1;
+				break;
+			}
+			wait_cycles += k_cycle_get_32() - start;
+		}
+
+		if(st7735_push_line(st7735_push_buf[idx], n)) {
+			ret = -1;
+			break;
+		}
+		busy = true;
+		idx ^= 1;
+		done += n;
 	}
 
-	if(st7735_write(ST7735_COLMOD_REG_BUF, sizeof(ST7735_COLMOD_REG_BUF))) {
-		return -1;
+	if(busy) {
+		start = k_cycle_get_32();
+		if(st7735_push_wait()) {
+			ret = -1;
+		}
+		wait_cycles += k_cycle_get_32() - start;
 	}
 
-	if(st7735_write(ST7735_DISPON_REG_BUF, sizeof(ST7735_DISPON_REG_BUF))) {
+	st7735_push_stats.bytes = length;
+	st7735_push_stats.frame_us = k_cyc_to_us_floor32(k_cycle_get_32() - frame_start);
+	st7735_push_stats.cpu_us = k_cyc_to_us_floor32(cpu_cycles);
+	st7735_push_stats.spi_us = k_cyc_to_us_floor32(st7735_push_spi_cycles);
+	st7735_push_stats.wait_us = k_cyc_to_us_floor32(wait_cycles);
+
+	return ret;
+}
+
+/*
+ * @brief set the window and start RAMWR, then pump its pixels
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+static int st7735_window_pump(uint8_t x, uint8_t y, uint8_t w, uint8_t h, size_t chunk, 
+		st7735_chunk_cb_t next, void *data) {
+	int ret = -1;
+
+	if(w == 0 || h == 0 || x + w > TFT144_COLUMN_PIXELS_MAX || y + h > TFT144_ROW_PIXELS_MAX) {
+		LOG_ERR("push window out of the screen!");
 		return -1;
 	}
 
-	if(st7735_write(ST7735_WHITE_CANVAS_BUF, sizeof(ST7735_WHITE_CANVAS_BUF))) {
-		return -1;
+	k_mutex_lock(&st7735_draw_lock, K_FOREVER);
+
+	if(!st7735_window_set(x, y, w, h)) {
+		ret = st7735_pump(w * h * ST7735_PIXEL_SIZE, chunk, next, data);
 	}
 
+	k_mutex_unlock(&st7735_draw_lock);
+
+	return ret;
+}
+
+static int st7735_push_next(uint32_t index, uint8_t *buf, size_t length, void *data) {
+	struct st7735_push_ctx_st *ctx = data;
+
+	return ctx->fill(ctx->y + index, buf, length / ST7735_PIXEL_SIZE, ctx->user_data);
+}
+
+/*
+ * @brief write a window of the screen line by line, double buffered
+ *        fill renders line N + 1 while line N is sent, see st7735_pump(). 
+ *
+ * @param x column of the top left pixel
+ * @param y row of the top left pixel
+ * @param w width
+ * @param h height
+ * @param fill renders w RGB565 pixels of a screen row, high byte first
+ * @param user_data passed to fill
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int st7735_push(uint8_t x, uint8_t y, uint8_t w, uint8_t h, st7735_line_cb_t fill, void *user_data) {
+	struct st7735_push_ctx_st ctx = {.y = y, .fill = fill, .user_data = user_data};
+
+	return st7735_window_pump(x, y, w, h, w * ST7735_PIXEL_SIZE, st7735_push_next, &ctx);
+}
+
+static int st7735_stream_next(uint32_t index, uint8_t *buf, size_t length, void *data) {
+	struct st7735_stream_ctx_st *ctx = data;
+
+	return ctx->read(buf, length, ctx->user_data);
+}
+
+/*
+ * @brief write a window of the screen from a sequential source
+ *        pixels are copied into RAM bounce buffers of ST7735_DMA_CHUNK_SIZE, 
+ *        EasyDMA can not read flash, and read fills chunk N + 1 while chunk N is sent. 
+ *
+ * @param x column of the top left pixel
+ * @param y row of the top left pixel
+ * @param w width
+ * @param h height
+ * @param read copies the next length byte of RGB565 pixels into buf
+ * @param user_data passed to read
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int st7735_stream(uint8_t x, uint8_t y, uint8_t w, uint8_t h, st7735_read_cb_t read, void *user_data) {
+	struct st7735_stream_ctx_st ctx = {.read = read, .user_data = user_data};
+
+	return st7735_window_pump(x, y, w, h, ST7735_DMA_CHUNK_SIZE, st7735_stream_next, &ctx);
+}
+
+static int st7735_flash_read(uint8_t *buf, size_t length, void *user_data) {
+	const uint8_t **src = user_data;
+
+	memcpy(buf, *src, length);
+	*src += length;
+
 	return 0;
 }
 
+static int st7735_m24m02_read(uint8_t *buf, size_t length, void *user_data) {
+	return m24m02_stream_read(user_data, buf, length) == (int)length ? 0 : -1;						// byte count, short at end of stream
+}
+
 /*
- * @brief write register func
+ * @brief write a window of the screen from an m24m02 stream
+ *        i2c reads of chunk N + 1 run while chunk N is sent, 
+ *        the stream crc can be checked with asset_verify() afterwards. 
+ *
+ * @param stream opened on w * h RGB565 pixels, row by row, high byte first
  *
- * @param st7735_xx_reg data struct will be written to reg
- * 
  * @retval 0 succeed
  * @retval -1 failed
  */
-static int st7735_write(uint8_t *buf, size_t length) {
+int st7735_blit_m24m02(uint8_t x, uint8_t y, uint8_t w, uint8_t h, struct m24m02_stream_st *stream) {
+	return st7735_stream(x, y, w, h, st7735_m24m02_read, stream);
+}
 
-	// write reg
-	if(gpio_pin_configure_dt(&st7735_cmd_data_gpiospec, GPIO_OUTPUT_ACTIVE)){						// cmd mode
-		return -1;
-	}
+/*
+ * @brief get the timing of the last st7735_push() / st7735_stream() frame
+ *        cpu_us + spi_us above frame_us is the overlap of rendering and sending. 
+ *
+ * @param stats where statistics will be copied to
+ */
+void st7735_push_stats_get(struct st7735_push_stats_st *stats) {
+	k_mutex_lock(&st7735_draw_lock, K_FOREVER);
+	*stats = st7735_push_stats;
+	k_mutex_unlock(&st7735_draw_lock);
+}
 
-	struct spi_buf tx_spi_buf = { .buf = buf, .len = 1};
-	struct spi_buf_set tx_spi_buf_set = {.buffers = &tx_spi_buf, .count = 1};
+static uint16_t st7735_rect_area(const struct st7735_rect_st *rect) {
+	return rect->w * rect->h;
+}
 
-	if(spi_write_dt(&st7735_spispec, &tx_spi_buf_set)) {
-		return -1;
+static void st7735_rect_union(const struct st7735_rect_st *a, const struct st7735_rect_st *b, 
+		struct st7735_rect_st *out) {
+	uint8_t x0 = MIN(a->x, b->x);
+	uint8_t y0 = MIN(a->y, b->y);
+	uint8_t x1 = MAX(a->x + a->w, b->x + b->w);
+	uint8_t y1 = MAX(a->y + a->h, b->y + b->h);
+
+	out->x = x0;
+	out->y = y0;
+	out->w = x1 - x0;
+	out->h = y1 - y0;
+}
+
+/*
+ * @brief mark a window damaged in this frame
+ *        it is merged with a damaged window when their bounding box costs 
+ *        no more than both plus a window setup, and with the one growing least 
+ *        when all ST7735_DIRTY_RECT_MAX entries are used. 
+ *
+ * @param x column of the top left pixel
+ * @param y row of the top left pixel
+ * @param w width
+ * @param h height
+ */
+void st7735_dirty_add(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+	if(x >= TFT144_COLUMN_PIXELS_MAX || y >= TFT144_ROW_PIXELS_MAX || w == 0 || h == 0) {
+		return;
+	}
+
+	struct st7735_rect_st rect = {
+		.x = x, 
+		.y = y, 
+		.w = MIN(w, TFT144_COLUMN_PIXELS_MAX - x), 
+		.h = MIN(h, TFT144_ROW_PIXELS_MAX - y), 
+	};
+	struct st7735_rect_st merged;
+
+	k_mutex_lock(&st7735_dirty_lock, K_FOREVER);
+
+	for(uint8_t i = 0; i < st7735_dirty_count; ) {
+		st7735_rect_union(&rect, &st7735_dirty_rects[i], &merged);
+
+		if(st7735_rect_area(&merged) <= st7735_rect_area(&rect) + 
+				st7735_rect_area(&st7735_dirty_rects[i]) + ST7735_DIRTY_MERGE_SLACK) {
+			rect = merged;
+			st7735_dirty_rects[i] = st7735_dirty_rects[--st7735_dirty_count];						// take it out, check again
+			i = 0;
+			continue;
+		}
+		i++;
 	}
 
-	if(length == 1) {																				// no extra data
+	if(st7735_dirty_count == ST7735_DIRTY_RECT_MAX) {												// full, grow the cheapest
+		uint8_t best = 0;
+		uint16_t best_growth = UINT16_MAX;
 
-		return 0;
+		for(uint8_t i = 0; i < st7735_dirty_count; i++) {
+			st7735_rect_union(&rect, &st7735_dirty_rects[i], &merged);
+			uint16_t growth = st7735_rect_area(&merged) - st7735_rect_area(&st7735_dirty_rects[i]);
 
-	} else {
-		// write data
-		if(gpio_pin_configure_dt(&st7735_cmd_data_gpiospec, GPIO_OUTPUT_INACTIVE)){					// data mode
-			return -1;
+			if(growth < best_growth) {
+				best_growth = growth;
+				best = i;
+			}
 		}
 
-		tx_spi_buf.buf = buf + 1;
-		tx_spi_buf.len = length - 1;
-		tx_spi_buf_set.buffers = &tx_spi_buf;
-		tx_spi_buf_set.count = 1;
+		st7735_rect_union(&rect, &st7735_dirty_rects[best], &st7735_dirty_rects[best]);
+	} else {
+		st7735_dirty_rects[st7735_dirty_count++] = rect;
+	}
+
+	k_mutex_unlock(&st7735_dirty_lock);
+}
 
-		if(spi_write_dt(&st7735_spispec, &tx_spi_buf_set)) {
+/*
+ * @brief end the frame, render every damaged window
+ *        windows damaged while rendering go to the next frame, 
+ *        so do the failed window and those after it when render fails. 
+ *
+ * @param render called once per damaged window, usually draws it with st7735_blit()
+ * @param user_data passed to render
+ *
+ * @retval 0 succeed
+ * @retval -1 failed
+ */
+int st7735_dirty_flush(st7735_render_cb_t render, void *user_data) {
+	struct st7735_rect_st rects[ST7735_DIRTY_RECT_MAX];
+	uint8_t count;
+
+	k_mutex_lock(&st7735_dirty_lock, K_FOREVER);
+	count = st7735_dirty_count;
+	memcpy(rects, st7735_dirty_rects, count * sizeof(rects[0]));
+	st7735_dirty_count = 0;
+	k_mutex_unlock(&st7735_dirty_lock);
+
+	for(uint8_t i = 0; i < count; i++) {
+		if(render(&rects[i], user_data)) {
+			for(; i < count; i++) {																	// not drawn, next frame
+				st7735_dirty_add(rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+			}
 			return -1;
 		}
-
-		return 0;
 	}
+
+	return 0;
 }
 
 /*